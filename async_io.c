@@ -0,0 +1,293 @@
+#include "async_io.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+/* Additional Definitions */
+
+typedef struct AIO_Metadata {
+    pthread_mutex_t lock;
+    // signaled when a request is queued or the engine is shutting down
+    pthread_cond_t submitted;
+    // signaled when a request completes
+    pthread_cond_t completed;
+    // the submission queue (FIFO)
+    AIO_Request *head;
+    AIO_Request *tail;
+    pthread_t *threads;
+    bool stopping;
+    // requests queued or being served
+    int numInFlight;
+    long numCompleted;
+} AIO_Metadata;
+
+/* Declarations */
+
+// use this helper to serve requests off the submission queue until the engine shuts down
+void *serveRequests(void *arg);
+
+// use this helper to run one request against the storage manager
+RC performRequest(AIO_Request *const request);
+
+// use this helper to fill out a request and submit it
+RC prepareRequest(AIO_Engine *const engine, AIO_Request *const request, AIO_Operation op, 
+        int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *buffers, 
+        AIO_Callback callback, void *userData);
+
+/* Async I/O Interface Engine Handling */
+
+RC initAsyncIO (AIO_Engine *const engine, int numThreads)
+{
+    if (numThreads <= 0) return RC_WRITE_FAILED;
+    AIO_Metadata *metadata = (AIO_Metadata *)malloc(sizeof(AIO_Metadata));
+    if (metadata == NULL) return RC_WRITE_FAILED;
+    pthread_mutex_init(&metadata->lock, NULL);
+    pthread_cond_init(&metadata->submitted, NULL);
+    pthread_cond_init(&metadata->completed, NULL);
+    metadata->head = NULL;
+    metadata->tail = NULL;
+    metadata->stopping = false;
+    metadata->numInFlight = 0;
+    metadata->numCompleted = 0;
+    metadata->threads = (pthread_t *)malloc(sizeof(pthread_t) * numThreads);
+    engine->numThreads = 0;
+    engine->mgmtData = metadata;
+    if (metadata->threads == NULL)
+    {
+        shutdownAsyncIO(engine);
+        return RC_WRITE_FAILED;
+    }
+
+    // start the I/O threads
+    for (int i = 0; i < numThreads; i++)
+    {
+        if (pthread_create(&metadata->threads[i], NULL, serveRequests, metadata) != 0)
+        {
+            shutdownAsyncIO(engine);
+            return RC_WRITE_FAILED;
+        }
+        engine->numThreads++;
+    }
+    return RC_OK;
+}
+
+RC shutdownAsyncIO (AIO_Engine *const engine)
+{
+    // make sure the metadata was successfully initialized
+    if (engine->mgmtData != NULL)
+    {
+        AIO_Metadata *metadata = (AIO_Metadata *)engine->mgmtData;
+
+        // the I/O threads finish whatever is queued before they exit
+        pthread_mutex_lock(&metadata->lock);
+        metadata->stopping = true;
+        pthread_cond_broadcast(&metadata->submitted);
+        pthread_mutex_unlock(&metadata->lock);
+        for (int i = 0; i < engine->numThreads; i++)
+            pthread_join(metadata->threads[i], NULL);
+
+        pthread_cond_destroy(&metadata->completed);
+        pthread_cond_destroy(&metadata->submitted);
+        pthread_mutex_destroy(&metadata->lock);
+        free(metadata->threads);
+        free(metadata);
+        engine->mgmtData = NULL;
+        engine->numThreads = 0;
+        return RC_OK;
+    }
+    return RC_FILE_HANDLE_NOT_INIT;
+}
+
+/* Async I/O Interface Requests */
+
+RC asyncReadBlocks (AIO_Engine *const engine, AIO_Request *const request, int startPage, int count, 
+		SM_FileHandle *fHandle, SM_PageHandle *buffers, AIO_Callback callback, void *userData)
+{
+    return prepareRequest(engine, request, AIO_READ, startPage, count, fHandle, buffers, callback, userData);
+}
+
+RC asyncWriteBlocks (AIO_Engine *const engine, AIO_Request *const request, int startPage, int count, 
+		SM_FileHandle *fHandle, SM_PageHandle *buffers, AIO_Callback callback, void *userData)
+{
+    return prepareRequest(engine, request, AIO_WRITE, startPage, count, fHandle, buffers, callback, userData);
+}
+
+RC asyncSyncPageFile (AIO_Engine *const engine, AIO_Request *const request, 
+		SM_FileHandle *fHandle, AIO_Callback callback, void *userData)
+{
+    return prepareRequest(engine, request, AIO_SYNC, 0, 0, fHandle, NULL, callback, userData);
+}
+
+RC submitRequest (AIO_Engine *const engine, AIO_Request *const request)
+{
+    // make sure the metadata was successfully initialized
+    if (engine->mgmtData != NULL)
+    {
+        AIO_Metadata *metadata = (AIO_Metadata *)engine->mgmtData;
+        request->result = RC_OK;
+        request->done = false;
+        request->next = NULL;
+
+        pthread_mutex_lock(&metadata->lock);
+        if (metadata->stopping)
+        {
+            pthread_mutex_unlock(&metadata->lock);
+            return RC_FILE_HANDLE_NOT_INIT;
+        }
+        // append to the submission queue and wake an I/O thread
+        if (metadata->tail == NULL) metadata->head = request;
+        else metadata->tail->next = request;
+        metadata->tail = request;
+        metadata->numInFlight++;
+        pthread_cond_signal(&metadata->submitted);
+        pthread_mutex_unlock(&metadata->lock);
+        return RC_OK;
+    }
+    return RC_FILE_HANDLE_NOT_INIT;
+}
+
+/* Async I/O Interface Completion */
+
+bool pollRequest (AIO_Engine *const engine, AIO_Request *const request)
+{
+    // make sure the metadata was successfully initialized
+    if (engine->mgmtData != NULL)
+    {
+        AIO_Metadata *metadata = (AIO_Metadata *)engine->mgmtData;
+        pthread_mutex_lock(&metadata->lock);
+        bool done = request->done;
+        pthread_mutex_unlock(&metadata->lock);
+        return done;
+    }
+    return false;
+}
+
+RC waitRequest (AIO_Engine *const engine, AIO_Request *const request)
+{
+    // make sure the metadata was successfully initialized
+    if (engine->mgmtData != NULL)
+    {
+        AIO_Metadata *metadata = (AIO_Metadata *)engine->mgmtData;
+        pthread_mutex_lock(&metadata->lock);
+        while (!request->done)
+            pthread_cond_wait(&metadata->completed, &metadata->lock);
+        RC result = request->result;
+        pthread_mutex_unlock(&metadata->lock);
+        return result;
+    }
+    return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC drainRequests (AIO_Engine *const engine)
+{
+    // make sure the metadata was successfully initialized
+    if (engine->mgmtData != NULL)
+    {
+        AIO_Metadata *metadata = (AIO_Metadata *)engine->mgmtData;
+        pthread_mutex_lock(&metadata->lock);
+        while (metadata->numInFlight > 0)
+            pthread_cond_wait(&metadata->completed, &metadata->lock);
+        pthread_mutex_unlock(&metadata->lock);
+        return RC_OK;
+    }
+    return RC_FILE_HANDLE_NOT_INIT;
+}
+
+/* Statistics Interface */
+
+int getNumInFlight (AIO_Engine *const engine)
+{
+    // make sure the metadata was successfully initialized
+    if (engine->mgmtData != NULL)
+    {
+        AIO_Metadata *metadata = (AIO_Metadata *)engine->mgmtData;
+        pthread_mutex_lock(&metadata->lock);
+        int numInFlight = metadata->numInFlight;
+        pthread_mutex_unlock(&metadata->lock);
+        return numInFlight;
+    }
+    return 0;
+}
+
+long getNumCompleted (AIO_Engine *const engine)
+{
+    // make sure the metadata was successfully initialized
+    if (engine->mgmtData != NULL)
+    {
+        AIO_Metadata *metadata = (AIO_Metadata *)engine->mgmtData;
+        pthread_mutex_lock(&metadata->lock);
+        long numCompleted = metadata->numCompleted;
+        pthread_mutex_unlock(&metadata->lock);
+        return numCompleted;
+    }
+    return 0;
+}
+
+/* Helpers */
+
+void *serveRequests(void *arg)
+{
+    AIO_Metadata *metadata = (AIO_Metadata *)arg;
+    pthread_mutex_lock(&metadata->lock);
+    while (true)
+    {
+        // wait for work, only exit once the queue is empty
+        while (metadata->head == NULL && !metadata->stopping)
+            pthread_cond_wait(&metadata->submitted, &metadata->lock);
+        if (metadata->head == NULL) break;
+        AIO_Request *request = metadata->head;
+        metadata->head = request->next;
+        if (metadata->head == NULL) metadata->tail = NULL;
+        pthread_mutex_unlock(&metadata->lock);
+
+        RC result = performRequest(request);
+        AIO_Callback callback = request->callback;
+
+        // a request with a callback is completed by it, and may be released by it, so it is 
+        // never marked done (nor touched again), only a request without one is published as done
+        if (callback != NULL)
+        {
+            request->result = result;
+            callback(request);
+            pthread_mutex_lock(&metadata->lock);
+        }
+        else
+        {
+            pthread_mutex_lock(&metadata->lock);
+            request->result = result;
+            request->done = true;
+        }
+        metadata->numInFlight--;
+        metadata->numCompleted++;
+        pthread_cond_broadcast(&metadata->completed);
+    }
+    pthread_mutex_unlock(&metadata->lock);
+    return NULL;
+}
+
+RC performRequest(AIO_Request *const request)
+{
+    switch (request->op)
+    {
+        case AIO_READ:
+            return readBlocks(request->startPage, request->count, request->fHandle, request->buffers);
+        case AIO_WRITE:
+            return writeBlocks(request->startPage, request->count, request->fHandle, request->buffers);
+        case AIO_SYNC:
+            return syncPageFile(request->fHandle);
+    }
+    return RC_FILE_MODE_NOT_SUPPORTED;
+}
+
+RC prepareRequest(AIO_Engine *const engine, AIO_Request *const request, AIO_Operation op, 
+        int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *buffers, 
+        AIO_Callback callback, void *userData)
+{
+    request->op = op;
+    request->fHandle = fHandle;
+    request->startPage = startPage;
+    request->count = count;
+    request->buffers = buffers;
+    request->callback = callback;
+    request->userData = userData;
+    return submitRequest(engine, request);
+}
@@ -0,0 +1,68 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+// Include return codes and methods for logging errors
+#include "dberror.h"
+
+// Include bool DT
+#include "dt.h"
+
+// Include the page file handles
+#include "storage_mgr.h"
+
+// the operations an I/O request can carry
+typedef enum AIO_Operation {
+	AIO_READ = 0,  // `readBlocks`
+	AIO_WRITE = 1, // `writeBlocks`
+	AIO_SYNC = 2   // `syncPageFile`, covers every write completed before it started
+} AIO_Operation;
+
+typedef struct AIO_Request AIO_Request;
+
+// called on an I/O thread once a request completes, the engine never touches the request 
+// after calling it so the callback may release it (and never marks it done, so a request 
+// with a callback can't be polled or waited for, use `drainRequests` instead)
+typedef void (*AIO_Callback)(AIO_Request *request);
+
+struct AIO_Request {
+	AIO_Operation op;
+	SM_FileHandle *fHandle;
+	int startPage;
+	int count;
+	SM_PageHandle *buffers;
+	AIO_Callback callback; // optional
+	void *userData;
+	// set by the engine
+	RC result;
+	bool done;
+	AIO_Request *next;
+};
+
+typedef struct AIO_Engine {
+	int numThreads;
+	void *mgmtData;
+} AIO_Engine;
+
+// Async I/O Interface Engine Handling
+RC initAsyncIO (AIO_Engine *const engine, int numThreads);
+RC shutdownAsyncIO (AIO_Engine *const engine);
+
+// Async I/O Interface Requests
+RC asyncReadBlocks (AIO_Engine *const engine, AIO_Request *const request, int startPage, int count, 
+		SM_FileHandle *fHandle, SM_PageHandle *buffers, AIO_Callback callback, void *userData);
+RC asyncWriteBlocks (AIO_Engine *const engine, AIO_Request *const request, int startPage, int count, 
+		SM_FileHandle *fHandle, SM_PageHandle *buffers, AIO_Callback callback, void *userData);
+RC asyncSyncPageFile (AIO_Engine *const engine, AIO_Request *const request, 
+		SM_FileHandle *fHandle, AIO_Callback callback, void *userData);
+RC submitRequest (AIO_Engine *const engine, AIO_Request *const request);
+
+// Async I/O Interface Completion
+bool pollRequest (AIO_Engine *const engine, AIO_Request *const request);
+RC waitRequest (AIO_Engine *const engine, AIO_Request *const request);
+RC drainRequests (AIO_Engine *const engine);
+
+// Statistics Interface
+int getNumInFlight (AIO_Engine *const engine);
+long getNumCompleted (AIO_Engine *const engine);
+
+#endif
@@ -0,0 +1,216 @@
+#include "hash_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// compares the open-addressing hash table against the old chained one (256 array lists, `key % size`)
+
+#define NUM_KEYS 65536
+#define NUM_OPS 4000000
+#define CHAINED_TABLE_SIZE 256
+#define ARRAY_LIST_SIZE 16
+
+double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void report(char *name, double seconds)
+{
+    printf("%-48s %8.3f s %12.0f ops/s\n", name, seconds, NUM_OPS / seconds);
+}
+
+/* the old chained table */
+
+typedef struct ChainedPair {
+    int key;
+    int value;
+} ChainedPair;
+
+typedef struct ChainedList {
+    int capacity;
+    int size;
+    ChainedPair *list;
+} ChainedList;
+
+typedef struct ChainedTable {
+    int size;
+    ChainedList *lists;
+} ChainedTable;
+
+void chainedInit(ChainedTable *ht, int size)
+{
+    ht->size = size;
+    ht->lists = malloc(sizeof(ChainedList) * size);
+    for (int i = 0; i < size; i++)
+    {
+        ht->lists[i].list = malloc(sizeof(ChainedPair) * ARRAY_LIST_SIZE);
+        ht->lists[i].capacity = ARRAY_LIST_SIZE;
+        ht->lists[i].size = 0;
+    }
+}
+
+int chainedGet(ChainedTable *ht, int key, int *value)
+{
+    ChainedList *al = &(ht->lists[key % ht->size]);
+    for (int j = 0; j < al->size; j++)
+    {
+        if (al->list[j].key == key)
+        {
+            *value = al->list[j].value;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int chainedSet(ChainedTable *ht, int key, int value)
+{
+    ChainedList *al = &(ht->lists[key % ht->size]);
+    for (int j = 0; j < al->size; j++)
+    {
+        if (al->list[j].key == key)
+        {
+            al->list[j].value = value;
+            return 0;
+        }
+    }
+    if (al->size == al->capacity)
+    {
+        al->capacity += ARRAY_LIST_SIZE;
+        al->list = realloc(al->list, sizeof(ChainedPair) * al->capacity);
+    }
+    al->list[al->size].key = key;
+    al->list[al->size].value = value;
+    al->size++;
+    return 0;
+}
+
+int chainedRemove(ChainedTable *ht, int key)
+{
+    ChainedList *al = &(ht->lists[key % ht->size]);
+    for (int j = 0; j < al->size; j++)
+    {
+        if (al->list[j].key == key)
+        {
+            for (int k = j; k < al->size - 1; k++)
+                al->list[k] = al->list[k + 1];
+            al->size--;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void chainedFree(ChainedTable *ht)
+{
+    for (int i = 0; i < ht->size; i++)
+        free(ht->lists[i].list);
+    free(ht->lists);
+}
+
+/* workloads */
+
+// a page table: `numKeys` resident pages looked up at random, and every 8th operation
+// evicts one of them for a page that isn't resident (as a buffer pool's misses would)
+// `stride` spaces the page numbers out like the pages of one page table partition
+// returns a checksum of the lookups so both tables can be checked against each other
+long pageTableChained(int numKeys, int stride, double *seconds)
+{
+    ChainedTable ht;
+    int *resident = malloc(sizeof(int) * numKeys);
+    int next = numKeys;
+    long checksum = 0;
+    unsigned int seed = 1;
+    chainedInit(&ht, CHAINED_TABLE_SIZE);
+    for (int i = 0; i < numKeys; i++)
+    {
+        resident[i] = i;
+        chainedSet(&ht, i * stride, i);
+    }
+    double start = now();
+    for (int i = 0; i < NUM_OPS; i++)
+    {
+        int slot = rand_r(&seed) % numKeys;
+        int value;
+        if (i % 8 == 0)
+        {
+            chainedRemove(&ht, resident[slot] * stride);
+            resident[slot] = next++;
+            chainedSet(&ht, resident[slot] * stride, slot);
+        }
+        else if (chainedGet(&ht, resident[slot] * stride, &value) == 0)
+            checksum += value;
+        else checksum -= 1;
+    }
+    *seconds = now() - start;
+    chainedFree(&ht);
+    free(resident);
+    return checksum;
+}
+
+long pageTableOpen(int numKeys, int stride, double *seconds)
+{
+    HT_TableHandle ht;
+    int *resident = malloc(sizeof(int) * numKeys);
+    int next = numKeys;
+    long checksum = 0;
+    unsigned int seed = 1;
+    initHashTable(&ht, numKeys);
+    for (int i = 0; i < numKeys; i++)
+    {
+        resident[i] = i;
+        setValue(&ht, i * stride, i);
+    }
+    double start = now();
+    for (int i = 0; i < NUM_OPS; i++)
+    {
+        int slot = rand_r(&seed) % numKeys;
+        int value;
+        if (i % 8 == 0)
+        {
+            removePair(&ht, resident[slot] * stride);
+            resident[slot] = next++;
+            setValue(&ht, resident[slot] * stride, slot);
+        }
+        else if (getValue(&ht, resident[slot] * stride, &value) == 0)
+            checksum += value;
+        else checksum -= 1;
+    }
+    *seconds = now() - start;
+    freeHashTable(&ht);
+    free(resident);
+    return checksum;
+}
+
+int compare(char *name, int numKeys, int stride)
+{
+    char label[64];
+    double chainedSeconds, openSeconds;
+    long chained = pageTableChained(numKeys, stride, &chainedSeconds);
+    long open = pageTableOpen(numKeys, stride, &openSeconds);
+    snprintf(label, sizeof(label), "chained, %s", name);
+    report(label, chainedSeconds);
+    snprintf(label, sizeof(label), "open addressing, %s", name);
+    report(label, openSeconds);
+    if (chained != open)
+    {
+        printf("the tables disagree on %s\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    int failed = 0;
+    printf("%d page table operations (1 in 8 an eviction)\n", NUM_OPS);
+    failed |= compare("256 pages", 256, 1);
+    failed |= compare("4096 pages", 4096, 1);
+    failed |= compare("65536 pages", NUM_KEYS, 1);
+    failed |= compare("4096 pages, 1 partition of 16", 4096, 16);
+    return failed;
+}
@@ -0,0 +1,196 @@
+#include "record_mgr.h"
+#include "buffer_mgr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// sweeps the record manager's options (pool size, replacement strategy, read-ahead) over a table
+// many times larger than the pool: full scans, then lookups of a hot set with a scan every so often
+
+#define BENCH_FILE_NAME "BENCH.bin"
+#define TABLE_NAME "bench"
+#define NUM_RECORDS 20000
+#define NUM_LOOKUPS 100000
+#define LOOKUPS_PER_SCAN 25000
+#define STRING_SIZE 96
+
+// the record manager's pool (to count its reads and hits)
+extern BM_BufferPool bufferPool;
+
+typedef struct BenchStrategy {
+    char *name;
+    ReplacementStrategy strategy;
+    void *stratData;
+} BenchStrategy;
+
+double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void report(char *name, double scanSeconds, double lookupSeconds, int numRead, int numHits)
+{
+    printf("%-36s %8.3f s %8.3f s %10d %10d\n", name, scanSeconds, lookupSeconds, numRead, numHits);
+}
+
+Schema *benchSchema()
+{
+    char **names = malloc(sizeof(char *) * 3);
+    DataType *dataTypes = malloc(sizeof(DataType) * 3);
+    int *typeLength = malloc(sizeof(int) * 3);
+    int *keys = malloc(sizeof(int));
+    names[0] = strdup("a");
+    names[1] = strdup("b");
+    names[2] = strdup("c");
+    dataTypes[0] = DT_INT;
+    dataTypes[1] = DT_STRING;
+    dataTypes[2] = DT_INT;
+    typeLength[0] = 0;
+    typeLength[1] = STRING_SIZE;
+    typeLength[2] = 0;
+    keys[0] = 0;
+    return createSchema(3, names, dataTypes, typeLength, 1, keys);
+}
+
+// fill the table with the default options, returning the ids of its records
+RID *buildTable(Schema *schema)
+{
+    RM_TableData table;
+    Record *record;
+    Value value;
+    char string[STRING_SIZE + 1];
+    RID *ids = malloc(sizeof(RID) * NUM_RECORDS);
+    remove(BENCH_FILE_NAME);
+    if (initRecordManager(BENCH_FILE_NAME) != RC_OK || createTable(TABLE_NAME, schema) != RC_OK
+        || openTable(&table, TABLE_NAME) != RC_OK)
+        return NULL;
+    createRecord(&record, schema);
+    memset(string, 'x', STRING_SIZE);
+    string[STRING_SIZE] = '\0';
+    for (int i = 0; i < NUM_RECORDS; i++)
+    {
+        value.dt = DT_INT;
+        value.v.intV = i;
+        setAttr(record, schema, 0, &value);
+        setAttr(record, schema, 2, &value);
+        value.dt = DT_STRING;
+        value.v.stringV = string;
+        setAttr(record, schema, 1, &value);
+        if (insertRecord(&table, record) != RC_OK)
+            return NULL;
+        ids[i] = record->id;
+    }
+    freeRecord(record);
+    closeTable(&table);
+    shutdownRecordManager();
+    return ids;
+}
+
+// returns how many records the scan saw
+int scanTable(RM_TableData *table, Record *record)
+{
+    RM_ScanHandle scan;
+    int count = 0;
+    startScan(table, &scan, NULL);
+    while (next(&scan, record) == RC_OK)
+        count++;
+    closeScan(&scan);
+    return count;
+}
+
+// run the workload with the given options, returns 1 if the table didn't read back whole
+int run(char *name, RM_Options *options, Schema *schema, RID *ids)
+{
+    RM_TableData table;
+    Record *record;
+    unsigned int seed = 1;
+    int failed = 0;
+    if (initRecordManagerWithOptions(options) != RC_OK || openTable(&table, TABLE_NAME) != RC_OK)
+    {
+        printf("%s: could not open the table\n", name);
+        return 1;
+    }
+    createRecord(&record, schema);
+
+    double start = now();
+    for (int i = 0; i < 2; i++)
+        failed |= scanTable(&table, record) != NUM_RECORDS;
+    double scanSeconds = now() - start;
+
+    // 9 in 10 lookups go to a tenth of the records
+    start = now();
+    for (int i = 0; i < NUM_LOOKUPS; i++)
+    {
+        int index = rand_r(&seed) % NUM_RECORDS;
+        if (rand_r(&seed) % 10 != 0)
+            index %= NUM_RECORDS / 10;
+        failed |= getRecord(&table, ids[index], record) != RC_OK;
+        if ((i + 1) % LOOKUPS_PER_SCAN == 0)
+            failed |= scanTable(&table, record) != NUM_RECORDS;
+    }
+    double lookupSeconds = now() - start;
+
+    report(name, scanSeconds, lookupSeconds, getNumReadIO(&bufferPool), getNumHits(&bufferPool));
+    freeRecord(record);
+    closeTable(&table);
+    shutdownRecordManager();
+    if (failed)
+        printf("%s: the table didn't read back whole\n", name);
+    return failed;
+}
+
+int main()
+{
+    int k = 3;
+    BenchStrategy strategies[] = {
+        { "FIFO", RS_FIFO, NULL },
+        { "LRU", RS_LRU, NULL },
+        { "CLOCK", RS_CLOCK, NULL },
+        { "LFU", RS_LFU, NULL },
+        { "LRU-2", RS_LRU_K, NULL },
+        { "LRU-3", RS_LRU_K, &k },
+        { "2Q", RS_2Q, NULL }
+    };
+    int poolSizes[] = { 16, 64, 256 };
+    int readAheads[] = { 0, 8 };
+    int failed = 0;
+    char label[64];
+    RM_Options options;
+
+    Schema *schema = benchSchema();
+    RID *ids = buildTable(schema);
+    if (ids == NULL)
+    {
+        printf("could not build the table\n");
+        return 1;
+    }
+    printf("%d records, 2 scans, then %d lookups (9 in 10 to a tenth of the records) with a scan every %d\n",
+        NUM_RECORDS, NUM_LOOKUPS, LOOKUPS_PER_SCAN);
+    printf("%-36s %10s %10s %10s %10s\n", "options", "scans", "lookups", "reads", "hits");
+    for (int i = 0; i < sizeof(poolSizes) / sizeof(int); i++)
+    {
+        for (int j = 0; j < sizeof(strategies) / sizeof(BenchStrategy); j++)
+        {
+            for (int r = 0; r < sizeof(readAheads) / sizeof(int); r++)
+            {
+                initRecordManagerOptions(&options);
+                options.fileName = BENCH_FILE_NAME;
+                options.numPages = poolSizes[i];
+                options.strategy = strategies[j].strategy;
+                options.stratData = strategies[j].stratData;
+                options.readAhead = readAheads[r];
+                snprintf(label, sizeof(label), "%d frames, %s, read-ahead %d", poolSizes[i], strategies[j].name,
+                    readAheads[r]);
+                failed |= run(label, &options, schema, ids);
+            }
+        }
+    }
+    free(ids);
+    freeSchema(schema);
+    remove(BENCH_FILE_NAME);
+    return failed;
+}
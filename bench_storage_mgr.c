@@ -0,0 +1,145 @@
+#include "storage_mgr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// compares the positional (pread/pwrite) storage manager against the old FILE* + fseek path
+
+#define BENCH_FILE_NAME "BENCH.bin"
+#define NUM_PAGES 4096
+#define NUM_OPS 100000
+#define NUM_THREADS 4
+
+typedef struct BenchThread {
+    SM_FileHandle *fHandle;
+    FILE *fp;
+    pthread_mutex_t *lock;
+    unsigned int seed;
+} BenchThread;
+
+double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void report(char *name, double seconds)
+{
+    printf("%-32s %8.3f s %12.0f ops/s\n", name, seconds, NUM_OPS / seconds);
+}
+
+/* the old stdio path */
+
+int stdioRead(FILE *fp, int pageNum, char *memPage)
+{
+    if (fseek(fp, pageNum * PAGE_SIZE, SEEK_SET) != 0) return 1;
+    return fread(memPage, sizeof(char), PAGE_SIZE, fp) != PAGE_SIZE;
+}
+
+int stdioWrite(FILE *fp, int pageNum, char *memPage)
+{
+    if (fseek(fp, pageNum * PAGE_SIZE, SEEK_SET) != 0) return 1;
+    return fwrite(memPage, sizeof(char), PAGE_SIZE, fp) != PAGE_SIZE;
+}
+
+/* threads */
+
+void *stdioReader(void *arg)
+{
+    BenchThread *thread = (BenchThread *)arg;
+    char page[PAGE_SIZE];
+
+    // the shared file position forces every read to hold the lock
+    for (int i = 0; i < NUM_OPS / NUM_THREADS; i++)
+    {
+        int pageNum = rand_r(&thread->seed) % NUM_PAGES;
+        pthread_mutex_lock(thread->lock);
+        stdioRead(thread->fp, pageNum, page);
+        pthread_mutex_unlock(thread->lock);
+    }
+    return NULL;
+}
+
+void *positionalReader(void *arg)
+{
+    BenchThread *thread = (BenchThread *)arg;
+    char page[PAGE_SIZE];
+    for (int i = 0; i < NUM_OPS / NUM_THREADS; i++)
+    {
+        int pageNum = rand_r(&thread->seed) % NUM_PAGES;
+        readBlock(pageNum, thread->fHandle, page);
+    }
+    return NULL;
+}
+
+double runThreads(void *(*reader)(void *), SM_FileHandle *fHandle, FILE *fp)
+{
+    pthread_t threads[NUM_THREADS];
+    BenchThread args[NUM_THREADS];
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    double start = now();
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        args[i].fHandle = fHandle;
+        args[i].fp = fp;
+        args[i].lock = &lock;
+        args[i].seed = i + 1;
+        pthread_create(&threads[i], NULL, reader, &args[i]);
+    }
+    for (int i = 0; i < NUM_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    return now() - start;
+}
+
+int main()
+{
+    SM_FileHandle fHandle;
+    char page[PAGE_SIZE];
+    memset(page, 'x', PAGE_SIZE);
+
+    // build the bench file
+    if (createPageFile(BENCH_FILE_NAME) != RC_OK) return 1;
+    if (openPageFile(BENCH_FILE_NAME, &fHandle) != RC_OK) return 1;
+    if (ensureCapacity(NUM_PAGES, &fHandle) != RC_OK) return 1;
+    FILE *fp = fopen(BENCH_FILE_NAME, "r+");
+    double start;
+
+    printf("%d random page operations over %d pages\n", NUM_OPS, NUM_PAGES);
+
+    srand(1);
+    start = now();
+    for (int i = 0; i < NUM_OPS; i++)
+        stdioRead(fp, rand() % NUM_PAGES, page);
+    report("stdio read", now() - start);
+
+    srand(1);
+    start = now();
+    for (int i = 0; i < NUM_OPS; i++)
+        readBlock(rand() % NUM_PAGES, &fHandle, page);
+    report("pread read", now() - start);
+
+    srand(1);
+    start = now();
+    for (int i = 0; i < NUM_OPS; i++)
+        stdioWrite(fp, rand() % NUM_PAGES, page);
+    fflush(fp);
+    report("stdio write", now() - start);
+
+    srand(1);
+    start = now();
+    for (int i = 0; i < NUM_OPS; i++)
+        writeBlock(rand() % NUM_PAGES, &fHandle, page);
+    report("pwrite write", now() - start);
+
+    report("stdio read (4 threads, locked)", runThreads(stdioReader, &fHandle, fp));
+    report("pread read (4 threads)", runThreads(positionalReader, &fHandle, fp));
+
+    fclose(fp);
+    closePageFile(&fHandle);
+    destroyPageFile(BENCH_FILE_NAME);
+    return 0;
+}
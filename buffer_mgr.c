@@ -1,14 +1,58 @@
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 #include "hash_table.h"
+#include "priority_queue.h"
+#include "async_io.h"
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 /* Additional Definitions */
 
-#define PAGE_TABLE_SIZE 256
+// the page table is split into this many partitions, each behind its own latch
+#define PAGE_TABLE_PARTITIONS 16
 
-typedef unsigned int TimeStamp;
+// each partition also indexes this many of its pages for pins that take no latch
+#define PAGE_TABLE_SLOTS 256
+
+// how many times a pin without a latch is retried after racing with a change to the page table
+#define OPTIMISTIC_PIN_RETRIES 4
+
+// K used by RS_LRU_K when `stratData` doesn't give one
+#define LRU_K_DEFAULT 2
+
+// RS_LFU halves every frequency once per this many pins per frame when `stratData` doesn't say otherwise
+#define LFU_DECAY_DEFAULT 8
+
+// RS_2Q keeps one in this many frames for pages seen once when `stratData` doesn't give a size
+#define TWO_Q_IN_SHARE 4
+
+// read-ahead starts once this many pages in a row were pinned, READ_AHEAD_MIN_WINDOW pages ahead
+// (the window grows by a page for every page read ahead that is used, up to a quarter of the pool)
+#define READ_AHEAD_TRIGGER 2
+#define READ_AHEAD_MIN_WINDOW 2
+
+// threads of the engine a pool reads ahead through
+#define READ_AHEAD_THREADS 2
+
+// the size of a huge page, a frame arena backed by them is rounded up to (and aligned to) a multiple of it
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// `forceFlushPool` copies (and then writes) at most this many bytes of pages at a time
+#define FLUSH_BATCH_SIZE (4 * 1024 * 1024)
+
+// a frame is LOADING from the time it is given a page until the page is read in
+typedef enum BM_FrameState {
+    FRAME_EMPTY = 0,
+    FRAME_LOADING = 1,
+    FRAME_VALID = 2
+} BM_FrameState;
 
 typedef struct BM_PageFrame {
     // the frame's buffer
@@ -17,79 +61,639 @@ typedef struct BM_PageFrame {
     PageNumber pageNum;
     // management data on the page frame
     int frameIndex;
-    int fixCount;
-    bool dirty;
-    bool occupied;
-    TimeStamp timeStamp;
+    atomic_int fixCount;
+    atomic_bool dirty;
+    _Atomic(BM_FrameState) state;
+    // pins of the page that were taken without a latch and not yet reported to the policy
+    atomic_int pendingHits;
+    // neighbours in the policy's frame list (frame indexes, -1 at either end)
+    int lruPrev;
+    int lruNext;
+    // set while a copy of the page is written (by the background writer or a force), so it isn't evicted or forced before the copy is on disk
+    bool writing;
+    // set when the page was read ahead, until it is pinned or evicted
+    atomic_bool prefetched;
+    // why the frame's last load failed (for the threads that were waiting for it)
+    RC loadResult;
+    // guards `state` and `writing` so threads can wait for `loaded` (broadcast when either changes)
+    pthread_mutex_t latch;
+    pthread_cond_t loaded;
 } BM_PageFrame;
 
-typedef struct BM_Metadata {
-    // an array of frames
-    BM_PageFrame *pageFrames;
-    // a page table that associates the a page ID with an index in pageFrames
-    HT_TableHandle pageTable;
-    // the file handle
-    SM_FileHandle pageFile;
-    // increments everytime a page is accessed (used for frame's timeStamp)
-    TimeStamp timeStamp;
+// an entry of a partition's lock-free index (a page and the frame holding it)
+typedef struct BM_PageTableSlot {
+    atomic_int pageNum;
+    _Atomic(BM_PageFrame *) frame;
+} BM_PageTableSlot;
+
+// one partition of the page table, pages go to partition `pageNum % PAGE_TABLE_PARTITIONS`
+typedef struct BM_PageTablePartition {
+    pthread_mutex_t latch;
+    HT_TableHandle table;
+    // a seqlock over `slots`: odd while a writer (holding `latch`) changes them, 
+    // so a reader without the latch can tell that what it read may be torn
+    atomic_uint version;
+    // the pages last mapped in the partition, direct mapped by page number
+    BM_PageTableSlot slots[PAGE_TABLE_SLOTS];
+} BM_PageTablePartition;
+
+// a doubly linked list threaded through the frames' lruPrev and lruNext
+typedef struct BM_FrameList {
+    int head;
+    int tail;
+    int size;
+} BM_FrameList;
+
+// bookkeeping for RS_FIFO
+typedef struct BM_FIFOState {
     // used to treat *pageFrames as a queue
     int queueIndex;
+} BM_FIFOState;
+
+// bookkeeping for RS_CLOCK
+typedef struct BM_CLOCKState {
+    // the frame the hand last stopped at
+    int clockHand;
+    // second chance bit of each frame, set on every access and cleared by the sweeping hand
+    bool *referenced;
+} BM_CLOCKState;
+
+// bookkeeping for RS_LRU_K
+typedef struct BM_LRUKState {
+    int k;
+    // references are numbered by this counter (64 bits, so it never wraps)
+    long clock;
+    // the last `k` references to each frame's page (most recent first) and how many there are
+    long *refs;
+    int *numRefs;
+    // the unpinned frames, the one with the oldest K-th most recent reference comes first
+    PQ_QueueHandle victims;
+    // the references of recently evicted pages, kept in a ring of `historySize` entries
+    // so a page that comes back soon after being evicted is not treated like a new one
+    HT_TableHandle historyTable;
+    PageNumber *historyPages;
+    long *historyRefs;
+    int *historyNumRefs;
+    int historySize;
+    int historyNext;
+} BM_LRUKState;
+
+// bookkeeping for RS_LFU
+typedef struct BM_LFUState {
+    // how many times each frame's page was pinned (halved every `decayInterval` pins)
+    int *counts;
+    int decayInterval;
+    int sinceDecay;
+    // the unpinned frames, least frequently used first (least recently unpinned on a tie)
+    PQ_QueueHandle victims;
+} BM_LFUState;
+
+// bookkeeping for RS_2Q
+typedef struct BM_2QState {
+    // A1in: pages read in once, the oldest at the tail (FIFO), trimmed once it holds more than `kIn`
+    BM_FrameList a1in;
+    // Am: pages referenced again after being evicted from A1in, the least recently used at the tail
+    BM_FrameList am;
+    // frames that never held a page
+    BM_FrameList empty;
+    int kIn;
+    // whether each frame's page is in Am rather than A1in
+    bool *hot;
+    // A1out: the numbers of the pages last evicted from A1in (no data), kept in a ring of `ghostSize`
+    HT_TableHandle ghostTable;
+    PageNumber *ghostPages;
+    int ghostSize;
+    int ghostNext;
+} BM_2QState;
+
+// a dirty frame waiting to be written by `forceFlushPool` or the background writer
+typedef struct BM_FlushEntry {
+    PageNumber pageNum;
+    int frameIndex;
+    // (the background writer goes back to the frame after it lets go of the policy's latch, when the array may have moved)
+    BM_PageFrame *pageFrame;
+} BM_FlushEntry;
+
+// the background writer of a pool (see startBackgroundWriter)
+typedef struct BM_BackgroundWriter {
+    pthread_t thread;
+    atomic_bool running;
+    // guards `stopping` so the thread can wait for `wake` between rounds
+    pthread_mutex_t latch;
+    pthread_cond_t wake;
+    bool stopping;
+    int cleanTarget;
+    int intervalMicros;
+    // the next victims, the pages being written and their copies (`cleanTarget` of each)
+    int *frames;
+    BM_FlushEntry *entries;
+    char **buffers;
+    // where the writer goes on scanning for a policy that doesn't tell it the next victims
+    int scanIndex;
+    // statistics
+    atomic_long numCleaned;
+    atomic_long numRounds;
+    double startTime;
+    double activeSeconds;
+} BM_BackgroundWriter;
+
+// sequential read-ahead of a pool (see setReadAhead)
+typedef struct BM_ReadAhead {
+    // the engine pages are read ahead through, started by the first prefetch
+    AIO_Engine engine;
+    atomic_bool started;
+    // how far ahead to read (0 if only prefetchPages reads ahead) and how far right now
+    int maxWindow;
+    int window;
+    // the last page pinned and how many pages in a row were pinned before it
+    PageNumber lastPage;
+    int runLength;
     // statistics
-    int numRead;
-    int numWrite;
+    atomic_long numPrefetched;
+    atomic_long numUsed;
+    atomic_long numWasted;
+} BM_ReadAhead;
+
+// a page being read ahead, the frame is pinned until the read completes
+typedef struct BM_Prefetch {
+    AIO_Request request;
+    BM_BufferPool *bm;
+    BM_PageFrame *pageFrame;
+    SM_PageHandle buffers[1];
+} BM_Prefetch;
+
+// the state of a shared page table (see initSharedPageTable)
+typedef struct BM_SharedState {
+    pthread_mutex_t latch;
+    // the pool caching each page (an index into `pools`)
+    HT_TableHandle owners;
+    BM_BufferPool *pools[BM_MAX_SHARED_POOLS];
+    int numPools;
+    // the page file of the pools (the handle of the first pool that attached) and its mode
+    SM_FileHandle *pageFile;
+    SM_FileMode mode;
+} BM_SharedState;
+
+typedef struct BM_Metadata {
+    // an array of frames (pointers, so a frame never moves while the pool grows)
+    BM_PageFrame **pageFrames;
+    // the frames allocated, the ones past bm->numPages were retired by resizeBufferPool (kept until shutdown
+    // so a racing pin can still look at them, and reused when the pool grows again)
+    int numFrames;
+    // the frames the pool started with are laid out next to each other: their structs in one array and
+    // their pages in one mapped arena (frames added by resizeBufferPool are allocated on their own)
+    BM_PageFrame *frameArray;
+    int arenaFrames;
+    char *arena;
+    size_t arenaSize;
+    // the memory the arena got (huge pages may not be available)
+    BM_FrameMemory memory;
+    // a page table that associates the a page ID with an index in pageFrames
+    BM_PageTablePartition pageTable[PAGE_TABLE_PARTITIONS];
+    // the pool's own file handle (NULL once it is the shared page table's) and how it was opened, and the handle 
+    // its pages are read and written through (its own, or once it is attached, the shared page table's, so all 
+    // the table's pools see one size and sync state)
+    SM_FileHandle *pageFile;
+    _Atomic(SM_FileHandle *) file;
+    SM_FileMode mode;
+    // the replacement policy and its state
+    const BM_ReplacementPolicy *policy;
+    void *policyData;
+    // guards the policy, the frames' dirty flags and lists, and every pin of an unpinned page
+    // (taken before any partition latch)
+    pthread_mutex_t policyLatch;
+    // statistics
+    atomic_int numRead;
+    atomic_int numWrite;
+    atomic_int numHits;
+    atomic_int numMisses;
+    atomic_int numFlushRuns;
+    atomic_long numEvictionWrites;
+    // the background writer (not running unless started)
+    BM_BackgroundWriter writer;
+    // read-ahead (guarded by the policy's latch)
+    BM_ReadAhead readAhead;
+    // the page table shared with other pools (NULL if the pool has its file to itself) and the pool's index in it
+    BM_SharedPageTable *shared;
+    int sharedIndex;
 } BM_Metadata;
 
 /* Declarations */
 
-BM_PageFrame *replacementFIFO(BM_BufferPool *const bm);
+void *initFIFO(BM_BufferPool *const bm, void *stratData);
+
+int replacementFIFO(BM_BufferPool *const bm, void *policyData);
+
+void shrinkFIFO(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+int nextFIFO(BM_BufferPool *const bm, void *policyData, int *frames, int max);
+
+void *initLRU(BM_BufferPool *const bm, void *stratData);
+
+void hitLRU(BM_BufferPool *const bm, void *policyData, int frameIndex);
+
+void accessLRU(BM_BufferPool *const bm, void *policyData, int frameIndex);
+
+void unpinLRU(BM_BufferPool *const bm, void *policyData, int frameIndex);
+
+int replacementLRU(BM_BufferPool *const bm, void *policyData);
+
+int nextLRU(BM_BufferPool *const bm, void *policyData, int *frames, int max);
+
+void growLRU(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+void shrinkLRU(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+void *initCLOCK(BM_BufferPool *const bm, void *stratData);
+
+void freeCLOCK(BM_BufferPool *const bm, void *policyData);
+
+void referenceCLOCK(BM_BufferPool *const bm, void *policyData, int frameIndex);
+
+void loadCLOCK(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
+
+int replacementCLOCK(BM_BufferPool *const bm, void *policyData);
+
+int nextCLOCK(BM_BufferPool *const bm, void *policyData, int *frames, int max);
+
+void growCLOCK(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+void shrinkCLOCK(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+void *initLRUK(BM_BufferPool *const bm, void *stratData);
+
+void freeLRUK(BM_BufferPool *const bm, void *policyData);
+
+void hitLRUK(BM_BufferPool *const bm, void *policyData, int frameIndex);
+
+void unpinLRUK(BM_BufferPool *const bm, void *policyData, int frameIndex);
+
+void loadLRUK(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
+
+int replacementLRUK(BM_BufferPool *const bm, void *policyData);
+
+int nextLRUK(BM_BufferPool *const bm, void *policyData, int *frames, int max);
+
+void evictLRUK(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
+
+void growLRUK(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+void shrinkLRUK(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+// use this helper to record a reference to the frame for RS_LRU_K (and take it out of the victims)
+void referenceLRUK(BM_LRUKState *lruK, int frameIndex);
+
+void *initLFU(BM_BufferPool *const bm, void *stratData);
+
+void freeLFU(BM_BufferPool *const bm, void *policyData);
+
+void hitLFU(BM_BufferPool *const bm, void *policyData, int frameIndex);
+
+void unpinLFU(BM_BufferPool *const bm, void *policyData, int frameIndex);
 
-BM_PageFrame *replacementLRU(BM_BufferPool *const bm);
+void loadLFU(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
 
-// use this helper to increment the pool's global timestamp and return it
-TimeStamp getTimeStamp(BM_Metadata *metadata);
+int replacementLFU(BM_BufferPool *const bm, void *policyData);
+
+int nextLFU(BM_BufferPool *const bm, void *policyData, int *frames, int max);
+
+void evictLFU(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
+
+void growLFU(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+void shrinkLFU(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+void *init2Q(BM_BufferPool *const bm, void *stratData);
+
+void free2Q(BM_BufferPool *const bm, void *policyData);
+
+void reference2Q(BM_BufferPool *const bm, void *policyData, int frameIndex);
+
+void load2Q(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
+
+int replacement2Q(BM_BufferPool *const bm, void *policyData);
+
+int next2Q(BM_BufferPool *const bm, void *policyData, int *frames, int max);
+
+void evict2Q(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
+
+void grow2Q(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+void shrink2Q(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+
+// use this helper to free state that is a single allocation
+void freePolicyData(BM_BufferPool *const bm, void *policyData);
+
+// use this helper to link a frame in at the head of a frame list
+void pushFrame(BM_Metadata *metadata, BM_FrameList *list, int frameIndex);
+
+// use this helper to link a frame in at the tail of a frame list
+void appendFrame(BM_Metadata *metadata, BM_FrameList *list, int frameIndex);
+
+// use this helper to unlink a frame from a frame list (if it is in it)
+void unlinkFrame(BM_Metadata *metadata, BM_FrameList *list, int frameIndex);
+
+// use this helper to find the unpinned frame closest to the tail of a frame list (-1 if there is none)
+int lastUnpinned(BM_Metadata *metadata, BM_FrameList *list);
+
+// use this helper to append the unpinned frames of a frame list to `frames`, from `frameIndex` towards the head,
+// until there are `max` or `limit` were taken, and return the frame it stopped before (-1 at the end of the list)
+int collectUnpinned(BM_Metadata *metadata, int frameIndex, int *frames, int *count, int max, int limit);
+
+// use this helper to tell the policy the frame's page was used without a pin
+void accessFrame(BM_BufferPool *const bm, int frameIndex);
+
+// use this helper to get the partition of the page table that maps `pageNum`
+BM_PageTablePartition *getPartition(BM_Metadata *metadata, PageNumber pageNum);
+
+// use this helper to find the frame holding `pageNum` under its partition's latch, NULL if there is none
+BM_PageFrame *findFrame(BM_Metadata *metadata, PageNumber pageNum);
+
+// use these helpers to map `pageNum` to a frame in its partition or unmap it (the partition's latch must be held)
+void mapPage(BM_PageTablePartition *partition, PageNumber pageNum, BM_PageFrame *pageFrame);
+void unmapPage(BM_PageTablePartition *partition, PageNumber pageNum);
+
+// use this helper to put `pageNum` and its frame (NULL to take it out) in the partition's lock-free index
+// (the partition's latch must be held)
+void indexPage(BM_PageTablePartition *partition, PageNumber pageNum, BM_PageFrame *pageFrame);
+
+// use this helper to pin a page that is already pinned without any latch, NULL if it has to be pinned under the latches
+BM_PageFrame *pinOptimistic(BM_BufferPool *const bm, PageNumber pageNum);
+
+// use this helper to tell the policy about the pins of a frame that took no latch (the policy's latch must be held)
+void reportHits(BM_BufferPool *const bm, BM_PageFrame *pageFrame);
+
+// use this helper to allocate an empty frame (NULL if out of memory)
+BM_PageFrame *newFrame(BM_Metadata *metadata, int frameIndex);
+
+// use this helper to free a frame
+void freeFrame(BM_Metadata *metadata, BM_PageFrame *pageFrame);
+
+// use this helper to wait until the page of a pinned frame is read in, returns why it wasn't if its load failed
+// (the frame is left empty, and the pin must be given back with `dropPin`)
+RC waitFrame(BM_PageFrame *pageFrame);
+
+// use this helper to give back a pin without holding the policy's latch, telling the policy if it was the last one
+void dropPin(BM_BufferPool *const bm, BM_PageFrame *pageFrame);
+
+// use this helper to have the policy pick a victim and return it evicted (NULL if all frames are pinned)
+BM_PageFrame *getVictim(BM_BufferPool *const bm);
 
 // use this help to evict the frame at frameIndex (write if occupied and dirty) and return the new empty frame
 BM_PageFrame *getAfterEviction(BM_BufferPool *const bm, int frameIndex);
 
+// use this helper to wait until a copy of the frame's page that is being written is on disk
+void waitWrite(BM_PageFrame *pageFrame);
+
+// use this helper to get the next victims from the policy (or the next unpinned frames if it can't tell)
+int getNextVictims(BM_BufferPool *const bm, int *frames, int max);
+
+// use this helper to write the dirty pages among the next victims, returns how many were written
+int cleanFrames(BM_BufferPool *const bm);
+
+// use this helper to copy a page that is about to be written into `buffer` (unless NULL), clear its dirty flag,
+// and mark its frame as being written until `writeCopies` is done with it (the policy's latch must be held)
+void startWrite(BM_Metadata *metadata, BM_PageFrame *pageFrame, char *buffer);
+
+// use this helper to write the copies of `count` pages (sorted by page number) with one vectored write per run
+// and no latch (mapped pages are synced instead), then let their frames be evicted again (dirty again if the write 
+// failed), counting the runs in `numRuns` (unless NULL) and setting `result` on failure, returns the pages written
+int writeCopies(BM_BufferPool *const bm, BM_FlushEntry *entries, char **buffers, int count, atomic_int *numRuns, RC *result);
+
+// the background writer's thread (`arg` is the pool)
+void *runBackgroundWriter(void *arg);
+
+// use this helper to follow the pins of a sequential scan and read the pages after it ahead (the policy's latch must be held)
+void readAhead(BM_BufferPool *const bm, PageNumber pageNum, bool prefetched);
+
+// use this helper to start reading a page that isn't in the pool into a victim frame (the policy's latch must be held)
+RC prefetchPage(BM_BufferPool *const bm, PageNumber pageNum);
+
+// called on an I/O thread once a page read ahead is in its frame
+void completePrefetch(AIO_Request *request);
+
+// use this helper to mark a LOADING frame as read in and wake up the threads waiting for it
+void finishLoad(BM_PageFrame *pageFrame);
+
+// use this helper to give up on a LOADING frame whose page couldn't be read in: the page is unmapped, the frame
+// is left empty, the threads waiting for it fail with `result`, and the loader's pin is given back 
+// (the policy's latch must be held)
+void failLoad(BM_BufferPool *const bm, BM_PageFrame *pageFrame, RC result);
+
+// use this helper to claim a page for the pool in its shared page table before it is mapped,
+// returns the pool that caches the page (`bm` if no other pool does)
+BM_BufferPool *claimPage(BM_BufferPool *const bm, PageNumber pageNum);
+
+// use this helper to give up the pool's claim on a page once it is unmapped (and written back)
+void releasePage(BM_BufferPool *const bm, PageNumber pageNum);
+
+// use this helper to find the pool of the shared page table caching a page (NULL if none or not shared)
+BM_BufferPool *findOwner(BM_BufferPool *const bm, PageNumber pageNum);
+
+// use this helper to give up the claims of a pool that is being shut down
+void detachBufferPool(BM_BufferPool *const bm);
+
+// use these helpers to open a page file in a handle of its own on the heap (NULL if it can't be opened), 
+// and to close and free it again
+SM_FileHandle *openFile(const char *fileName, SM_FileMode mode, RC *result);
+RC closeFile(SM_FileHandle *fHandle);
+
+// use this helper to get the monotonic time in seconds
+double getSeconds();
+
+// use this helper to order flush entries by page number (for qsort)
+int compareFlushEntries(const void *a, const void *b);
+
+// use this helper to append `count` empty frames to the pool (the policy's latch must be held)
+RC addFrames(BM_BufferPool *const bm, int count);
+
+// use this helper to evict the pages of the last `count` frames and retire them, moving the pinned ones to frames 
+// that stay (the policy's latch must be held)
+RC removeFrames(BM_BufferPool *const bm, int count);
+
+// use this helper to swap the occupied frame at `from` with the empty one at `to`, so its page is mapped to `to`
+// (the policy's latch must be held)
+void moveFrame(BM_BufferPool *const bm, int from, int to);
+
+// use this helper to give a frame its memory (if it has none and isn't mapped)
+RC allocFrameData(BM_Metadata *metadata, BM_PageFrame *pageFrame);
+void releaseFrameData(BM_Metadata *metadata, BM_PageFrame *pageFrame);
+
+// use this helper to get a frame's place in the arena (kept when a shrink moves the frame), -1 if it has none
+int arenaSlot(BM_Metadata *metadata, BM_PageFrame *pageFrame);
+RC allocArena(BM_Metadata *metadata, int numPages, BM_FrameMemory memory);
+char *mapArena(size_t size, size_t alignment, int flags);
+void freeArena(BM_Metadata *metadata);
+
+// use this helper to unlink the frames past bm->numPages from a list
+void dropFrames(BM_Metadata *metadata, BM_FrameList *list, int numPages);
+
+/* Built-in Policies */
+
+static const BM_ReplacementPolicy policyFIFO = {
+    .name = "FIFO", .init = initFIFO, .shutdown = freePolicyData, .chooseVictim = replacementFIFO,
+    .onShrink = shrinkFIFO, .nextVictims = nextFIFO
+};
+
+static const BM_ReplacementPolicy policyLRU = {
+    .name = "LRU", .init = initLRU, .shutdown = freePolicyData, .onHit = hitLRU, .onAccess = accessLRU,
+    .onUnpin = unpinLRU, .chooseVictim = replacementLRU, .onGrow = growLRU, .onShrink = shrinkLRU,
+    .nextVictims = nextLRU
+};
+
+static const BM_ReplacementPolicy policyCLOCK = {
+    .name = "CLOCK", .init = initCLOCK, .shutdown = freeCLOCK, .onHit = referenceCLOCK, .onAccess = referenceCLOCK,
+    .onUnpin = referenceCLOCK, .onLoad = loadCLOCK, .chooseVictim = replacementCLOCK, .onGrow = growCLOCK,
+    .onShrink = shrinkCLOCK, .nextVictims = nextCLOCK
+};
+
+static const BM_ReplacementPolicy policyLRUK = {
+    .name = "LRU-K", .init = initLRUK, .shutdown = freeLRUK, .onHit = hitLRUK, .onUnpin = unpinLRUK,
+    .onLoad = loadLRUK, .chooseVictim = replacementLRUK, .onEvict = evictLRUK, .onGrow = growLRUK,
+    .onShrink = shrinkLRUK, .nextVictims = nextLRUK
+};
+
+static const BM_ReplacementPolicy policyLFU = {
+    .name = "LFU", .init = initLFU, .shutdown = freeLFU, .onHit = hitLFU, .onUnpin = unpinLFU,
+    .onLoad = loadLFU, .chooseVictim = replacementLFU, .onEvict = evictLFU, .onGrow = growLFU,
+    .onShrink = shrinkLFU, .nextVictims = nextLFU
+};
+
+static const BM_ReplacementPolicy policy2Q = {
+    .name = "2Q", .init = init2Q, .shutdown = free2Q, .onHit = reference2Q, .onAccess = reference2Q,
+    .onUnpin = reference2Q, .onLoad = load2Q, .chooseVictim = replacement2Q, .onEvict = evict2Q, .onGrow = grow2Q,
+    .onShrink = shrink2Q, .nextVictims = next2Q
+};
+
+// the policy of each strategy, registered ones take the free slots after the built-in ones
+static const BM_ReplacementPolicy *policies[RS_MAX_POLICIES] = {
+    [RS_FIFO] = &policyFIFO,
+    [RS_LRU] = &policyLRU,
+    [RS_CLOCK] = &policyCLOCK,
+    [RS_LFU] = &policyLFU,
+    [RS_LRU_K] = &policyLRUK,
+    [RS_2Q] = &policy2Q
+};
+
+// guards `policies`, so a policy can be registered while other threads start pools
+static pthread_mutex_t policiesLatch = PTHREAD_MUTEX_INITIALIZER;
+
 /* Buffer Manager Interface Pool Handling */
 
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData)
 {
+    return initBufferPoolMode(bm, pageFileName, numPages, strategy, stratData, SM_MODE_DEFAULT);
+}
+
+RC initBufferPoolMode(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, SM_FileMode mode)
+{
+    return initBufferPoolMemory(bm, pageFileName, numPages, strategy, stratData, mode, BM_MEMORY_DEFAULT);
+}
+
+RC initBufferPoolMemory(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, SM_FileMode mode, BM_FrameMemory memory)
+{
+    // make sure the strategy has a policy
+    const BM_ReplacementPolicy *policy = getReplacementPolicy(strategy);
+    if (policy == NULL)
+    {
+        bm->mgmtData = NULL;
+        return RC_WRITE_FAILED;
+    }
+
     // initialize the metadata
     BM_Metadata *metadata = (BM_Metadata *)malloc(sizeof(BM_Metadata));
-    HT_TableHandle *pageTabe = &(metadata->pageTable);
-    metadata->timeStamp = 0;
-
-    // start the queue from the last element as it gets incremented by one and modded 
-    // at the start of each call of replacementFIFO
-    metadata->queueIndex = bm->numPages - 1;
     metadata->numRead = 0;
     metadata->numWrite = 0;
-    RC result = openPageFile((char *)pageFileName, &(metadata->pageFile));
+    metadata->numHits = 0;
+    metadata->numMisses = 0;
+    metadata->numFlushRuns = 0;
+    metadata->numEvictionWrites = 0;
+    metadata->writer.running = false;
+    metadata->writer.numCleaned = 0;
+    metadata->writer.numRounds = 0;
+    metadata->writer.activeSeconds = 0;
+    metadata->readAhead.started = false;
+    metadata->readAhead.maxWindow = 0;
+    metadata->readAhead.window = READ_AHEAD_MIN_WINDOW;
+    metadata->readAhead.lastPage = NO_PAGE;
+    metadata->readAhead.runLength = 0;
+    metadata->readAhead.numPrefetched = 0;
+    metadata->readAhead.numUsed = 0;
+    metadata->readAhead.numWasted = 0;
+    metadata->shared = NULL;
+    metadata->sharedIndex = -1;
+    metadata->mode = mode;
+    metadata->policy = policy;
+    RC result;
+    metadata->pageFile = openFile(pageFileName, mode, &result);
+    metadata->file = metadata->pageFile;
+    if (result == RC_OK && allocArena(metadata, numPages, memory) != RC_OK)
+    {
+        closeFile(metadata->pageFile);
+        result = RC_WRITE_FAILED;
+    }
     if (result == RC_OK)
     {
-        initHashTable(pageTabe, PAGE_TABLE_SIZE);
-        metadata->pageFrames = (BM_PageFrame *)malloc(sizeof(BM_PageFrame) * numPages);
-        for (int i = 0; i < numPages; i++)
+        for (int i = 0; i < PAGE_TABLE_PARTITIONS; i++)
         {
-            metadata->pageFrames[i].frameIndex = i;
-            metadata->pageFrames[i].data = (char *)malloc(PAGE_SIZE);
-            metadata->pageFrames[i].fixCount = 0;
-            metadata->pageFrames[i].dirty = false;
-            metadata->pageFrames[i].occupied = false;
-            metadata->pageFrames[i].timeStamp = getTimeStamp(metadata);
+            pthread_mutex_init(&(metadata->pageTable[i].latch), NULL);
+            initHashTable(&(metadata->pageTable[i].table), numPages / PAGE_TABLE_PARTITIONS + 1);
+            atomic_init(&(metadata->pageTable[i].version), 0);
+            for (int j = 0; j < PAGE_TABLE_SLOTS; j++)
+            {
+                atomic_init(&(metadata->pageTable[i].slots[j].pageNum), NO_PAGE);
+                atomic_init(&(metadata->pageTable[i].slots[j].frame), NULL);
+            }
         }
+        pthread_mutex_init(&(metadata->policyLatch), NULL);
+        pthread_mutex_init(&(metadata->writer.latch), NULL);
+        pthread_cond_init(&(metadata->writer.wake), NULL);
+        metadata->pageFrames = (BM_PageFrame **)malloc(sizeof(BM_PageFrame *) * numPages);
+        for (int i = 0; i < numPages; i++)
+            metadata->pageFrames[i] = newFrame(metadata, i);
+        metadata->numFrames = numPages;
         bm->mgmtData = (void *)metadata;
         bm->numPages = numPages;
-        bm->pageFile = (char *)&(metadata->pageFile);
+        bm->pageFile = (char *)metadata->file;
         bm->strategy = strategy;
+
+        // the policy sets itself up once the frames exist, and rejects `stratData` it can't use
+        metadata->policyData = NULL;
+        if (policy->init != NULL)
+        {
+            metadata->policyData = policy->init(bm, stratData);
+            if (metadata->policyData == NULL)
+            {
+                for (int i = 0; i < numPages; i++)
+                    freeFrame(metadata, metadata->pageFrames[i]);
+                freeArena(metadata);
+                for (int i = 0; i < PAGE_TABLE_PARTITIONS; i++)
+                {
+                    pthread_mutex_destroy(&(metadata->pageTable[i].latch));
+                    freeHashTable(&(metadata->pageTable[i].table));
+                }
+                pthread_mutex_destroy(&(metadata->policyLatch));
+                pthread_mutex_destroy(&(metadata->writer.latch));
+                pthread_cond_destroy(&(metadata->writer.wake));
+                closeFile(metadata->pageFile);
+                free(metadata->pageFrames);
+                free(metadata);
+                bm->mgmtData = NULL;
+                return RC_WRITE_FAILED;
+            }
+        }
         return RC_OK;
     }
-    else
+    else 
     {
         // in case the file can't be open, set the metadata to NULL
+        free(metadata);
         bm->mgmtData = NULL;
         return result;
     }
@@ -101,24 +705,42 @@ RC shutdownBufferPool(BM_BufferPool *const bm)
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        HT_TableHandle *pageTabe = &(metadata->pageTable);
+        BM_PageFrame **pageFrames = metadata->pageFrames;
+
+        // pages being read ahead hold pins until their reads complete
+        if (metadata->readAhead.started)
+            drainRequests(&(metadata->readAhead.engine));
         
         // "It is an error to shutdown a buffer pool that has pinned pages."
+        // (no other thread may use the pool once it is being shut down)
         for (int i = 0; i < bm->numPages; i++)
         {
-            if (pageFrames[i].fixCount > 0) return RC_WRITE_FAILED;
+            if (pageFrames[i]->fixCount > 0) return RC_WRITE_FAILED;
         }
+        stopBackgroundWriter(bm);
+        if (metadata->readAhead.started)
+            shutdownAsyncIO(&(metadata->readAhead.engine));
         forceFlushPool(bm);
-        for (int i = 0; i < bm->numPages; i++)
+        detachBufferPool(bm);
+
+        // (the first pool attached to a shared page table gave its handle to the table)
+        if (metadata->pageFile != NULL)
+            closeFile(metadata->pageFile);
+        if (metadata->policy->shutdown != NULL)
+            metadata->policy->shutdown(bm, metadata->policyData);
+
+        // free the frames (retired ones included), the page table and metadata
+        for (int i = 0; i < metadata->numFrames; i++)
+            freeFrame(metadata, pageFrames[i]);
+        freeArena(metadata);
+        for (int i = 0; i < PAGE_TABLE_PARTITIONS; i++)
         {
-            // free each page frame's data
-            free(pageFrames[i].data);
+            pthread_mutex_destroy(&(metadata->pageTable[i].latch));
+            freeHashTable(&(metadata->pageTable[i].table));
         }
-        closePageFile(&(metadata->pageFile));
-
-        // free the pageFrames array and metadata
-        freeHashTable(pageTabe);
+        pthread_mutex_destroy(&(metadata->policyLatch));
+        pthread_mutex_destroy(&(metadata->writer.latch));
+        pthread_cond_destroy(&(metadata->writer.wake));
         free(pageFrames);
         free(metadata);
         return RC_OK;
@@ -132,21 +754,128 @@ RC forceFlushPool(BM_BufferPool *const bm)
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        for (int i = 0; i < bm->numPages; i++)
+        RC result = RC_OK;
+        bool flushed = false;
+        bool retry = true;
+
+        // the pages are copied under the policy's latch a batch at a time, and written (and synced) without it
+        // (mapped pages are synced straight from the mapping)
+        int batchSize = FLUSH_BATCH_SIZE / metadata->file->pageSize;
+        if (batchSize < 1) batchSize = 1;
+        char **buffers = (char **)calloc(batchSize, sizeof(char *));
+        if (buffers == NULL) return RC_WRITE_FAILED;
+        for (int i = 0; i < batchSize && metadata->mode != SM_MODE_MMAP; i++)
+        {
+            if (posix_memalign((void **)&(buffers[i]), SM_IO_ALIGNMENT, metadata->file->pageSize) != 0)
+            {
+                for (int j = 0; j < i; j++)
+                    free(buffers[j]);
+                free(buffers);
+                return RC_WRITE_FAILED;
+            }
+        }
+        while (retry)
         {
-            // write the occupied, dirty, and unpinned pages to disk
-            if (pageFrames[i].occupied && pageFrames[i].dirty && pageFrames[i].fixCount == 0)
+            retry = false;
+
+            // collect the occupied, dirty, and unpinned pages and sort them by page number
+            pthread_mutex_lock(&(metadata->policyLatch));
+            BM_PageFrame **pageFrames = metadata->pageFrames;
+            BM_FlushEntry *entries = (BM_FlushEntry *)malloc(sizeof(BM_FlushEntry) * bm->numPages);
+            BM_PageFrame **busy = (BM_PageFrame **)malloc(sizeof(BM_PageFrame *) * bm->numPages);
+            int numEntries = 0;
+            int numBusy = 0;
+            for (int i = 0; entries != NULL && busy != NULL && i < bm->numPages; i++)
+            {
+                if (pageFrames[i]->state == FRAME_VALID && pageFrames[i]->dirty && pageFrames[i]->fixCount == 0)
+                {
+                    entries[numEntries].pageNum = pageFrames[i]->pageNum;
+                    entries[numEntries].frameIndex = i;
+                    entries[numEntries].pageFrame = pageFrames[i];
+                    numEntries++;
+                }
+            }
+            pthread_mutex_unlock(&(metadata->policyLatch));
+            if (entries == NULL || busy == NULL)
+            {
+                free(entries);
+                free(busy);
+                result = RC_WRITE_FAILED;
+                break;
+            }
+            qsort(entries, numEntries, sizeof(BM_FlushEntry), compareFlushEntries);
+
+            for (int batchStart = 0; batchStart < numEntries; batchStart += batchSize)
             {
-                writeBlock(pageFrames[i].pageNum, &(metadata->pageFile), pageFrames[i].data);
-                metadata->numWrite++;
-                pageFrames[i].timeStamp = getTimeStamp(metadata);
+                int batchEnd = (batchStart + batchSize < numEntries) ? batchStart + batchSize : numEntries;
+                int count = 0;
+
+                // copy the pages of the batch that are still dirty and unpinned (and in the same frame)
+                pthread_mutex_lock(&(metadata->policyLatch));
+                for (int i = batchStart; i < batchEnd; i++)
+                {
+                    BM_PageFrame *pageFrame = entries[i].pageFrame;
+                    if (pageFrame->state != FRAME_VALID || pageFrame->pageNum != entries[i].pageNum 
+                        || !pageFrame->dirty || pageFrame->fixCount > 0)
+                        continue;
 
-                // clear the dirty bool
-                pageFrames[i].dirty = false;
+                    // an older copy another write is writing must not land after this one, so flush it again after that
+                    if (pageFrame->writing)
+                    {
+                        busy[numBusy++] = pageFrame;
+                        continue;
+                    }
+                    accessFrame(bm, pageFrame->frameIndex);
+                    startWrite(metadata, pageFrame, buffers[count]);
+                    entries[batchStart + count] = entries[i];
+                    count++;
+                }
+                pthread_mutex_unlock(&(metadata->policyLatch));
+                writeCopies(bm, &(entries[batchStart]), buffers, count, &(metadata->numFlushRuns), &result);
+                flushed = flushed || count > 0;
             }
+            for (int i = 0; i < numBusy; i++)
+                waitWrite(busy[i]);
+            retry = numBusy > 0;
+            free(entries);
+            free(busy);
         }
-        return RC_OK;
+
+        // one sync request covers the whole flush, the file's sync policy decides when it is fsync'd
+        if (flushed)
+        {
+            RC syncResult = syncPageFile(metadata->file);
+            if (result == RC_OK) result = syncResult;
+        }
+        for (int i = 0; i < batchSize; i++)
+            free(buffers[i]);
+        free(buffers);
+        return result;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        RC result = RC_OK;
+        if (numPages < 1) return RC_WRITE_FAILED;
+
+        // pages being read ahead hold pins until their reads complete, so let them finish first
+        if (metadata->readAhead.started)
+            drainRequests(&(metadata->readAhead.engine));
+
+        // the policy's latch keeps every unpinned frame unpinned while the pool changes
+        pthread_mutex_lock(&(metadata->policyLatch));
+        if (numPages > bm->numPages)
+            result = addFrames(bm, numPages - bm->numPages);
+        else if (numPages < bm->numPages)
+            result = removeFrames(bm, bm->numPages - numPages);
+        pthread_mutex_unlock(&(metadata->policyLatch));
+        return result;
     }
     else return RC_FILE_HANDLE_NOT_INIT;
 }
@@ -159,20 +888,25 @@ RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        HT_TableHandle *pageTabe = &(metadata->pageTable);
-        int frameIndex;
+        RC result = RC_IM_KEY_NOT_FOUND;
 
-        // get the mapped frameIndex from pageNum
-        if (getValue(pageTabe, page->pageNum, &frameIndex) == 0)
+        // get the frame holding the page
+        pthread_mutex_lock(&(metadata->policyLatch));
+        BM_PageFrame *pageFrame = findFrame(metadata, page->pageNum);
+        if (pageFrame != NULL)
         {
-            pageFrames[frameIndex].timeStamp = getTimeStamp(metadata);
+            accessFrame(bm, pageFrame->frameIndex);
 
             // set dirty bool
-            pageFrames[frameIndex].dirty = true;
-            return RC_OK;
+            pageFrame->dirty = true;
+            result = RC_OK;
         }
-        else return RC_IM_KEY_NOT_FOUND;
+        pthread_mutex_unlock(&(metadata->policyLatch));
+
+        // a page pinned through another pool of the shared page table is in that pool
+        BM_BufferPool *owner = (result == RC_IM_KEY_NOT_FOUND) ? findOwner(bm, page->pageNum) : NULL;
+        if (owner != NULL && owner != bm) return markDirty(owner, page);
+        return result;
     }
     else return RC_FILE_HANDLE_NOT_INIT;
 }
@@ -183,22 +917,34 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page)
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        HT_TableHandle *pageTabe = &(metadata->pageTable);
-        int frameIndex;
 
-        // get the mapped frameIndex from pageNum
-        if (getValue(pageTabe, page->pageNum, &frameIndex) == 0)
+        // get the frame holding the page
+        BM_PageFrame *pageFrame = findFrame(metadata, page->pageNum);
+        if (pageFrame != NULL)
         {
-            pageFrames[frameIndex].timeStamp = getTimeStamp(metadata);
-
             // decrement (not below 0)
-            pageFrames[frameIndex].fixCount--;
-            if (pageFrames[frameIndex].fixCount < 0)
-                pageFrames[frameIndex].fixCount = 0;
+            int fixCount = pageFrame->fixCount;
+            while (fixCount > 0 && !atomic_compare_exchange_weak(&(pageFrame->fixCount), &fixCount, fixCount - 1));
+
+            // (unpinning an unpinned page tells the policy again, a frame pinned again
+            // in the meantime has only been used, and one a shrink retired in the meantime is left alone)
+            pthread_mutex_lock(&(metadata->policyLatch));
+            if (pageFrame->state != FRAME_EMPTY)
+            {
+                reportHits(bm, pageFrame);
+                if (pageFrame->fixCount > 0)
+                    accessFrame(bm, pageFrame->frameIndex);
+                else if (metadata->policy->onUnpin != NULL)
+                    metadata->policy->onUnpin(bm, metadata->policyData, pageFrame->frameIndex);
+            }
+            pthread_mutex_unlock(&(metadata->policyLatch));
             return RC_OK;
         }
-        else return RC_IM_KEY_NOT_FOUND;
+
+        // a page pinned through another pool of the shared page table is unpinned there
+        BM_BufferPool *owner = findOwner(bm, page->pageNum);
+        if (owner != NULL && owner != bm) return unpinPage(owner, page);
+        return RC_IM_KEY_NOT_FOUND;
     }
     else return RC_FILE_HANDLE_NOT_INIT;
 }
@@ -209,28 +955,57 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        HT_TableHandle *pageTabe = &(metadata->pageTable);
-        int frameIndex;
+        RC result = RC_IM_KEY_NOT_FOUND;
+        BM_FlushEntry entry;
+        bool started = false;
 
-        // get the mapped frameIndex from pageNum
-        if (getValue(pageTabe, page->pageNum, &frameIndex) == 0)
+        // the page is copied under the policy's latch and written (and synced) without it
+        // (a mapped page is synced straight from the mapping)
+        char *buffer = NULL;
+        if (metadata->mode != SM_MODE_MMAP 
+            && posix_memalign((void **)&buffer, SM_IO_ALIGNMENT, metadata->file->pageSize) != 0)
+            return RC_WRITE_FAILED;
+
+        // get the frame holding the page (after an older copy another write is writing, waited for without the latch)
+        pthread_mutex_lock(&(metadata->policyLatch));
+        BM_PageFrame *pageFrame = findFrame(metadata, page->pageNum);
+        while (pageFrame != NULL && pageFrame->fixCount == 0 && pageFrame->writing)
+        {
+            pthread_mutex_unlock(&(metadata->policyLatch));
+            waitWrite(pageFrame);
+            pthread_mutex_lock(&(metadata->policyLatch));
+            pageFrame = findFrame(metadata, page->pageNum);
+        }
+        if (pageFrame != NULL)
         {
-            pageFrames[frameIndex].timeStamp = getTimeStamp(metadata);
+            accessFrame(bm, pageFrame->frameIndex);
 
             // only force the page if it is not pinned
-            if (pageFrames[frameIndex].fixCount == 0)
+            if (pageFrame->fixCount == 0)
             {
-                writeBlock(page->pageNum, &(metadata->pageFile), pageFrames[frameIndex].data);
-                metadata->numWrite++;
-
-                // clear dirty bool
-                pageFrames[frameIndex].dirty = false;
-                return RC_OK;
+                startWrite(metadata, pageFrame, buffer);
+                entry.pageNum = page->pageNum;
+                entry.frameIndex = pageFrame->frameIndex;
+                entry.pageFrame = pageFrame;
+                started = true;
             }
-            else return RC_WRITE_FAILED;
+            else result = RC_WRITE_FAILED;
         }
-        else return RC_IM_KEY_NOT_FOUND;
+        pthread_mutex_unlock(&(metadata->policyLatch));
+
+        // the file's sync policy decides when the write is fsync'd (concurrent forces can share the fsync)
+        if (started)
+        {
+            result = RC_OK;
+            writeCopies(bm, &entry, &buffer, 1, NULL, &result);
+            if (result == RC_OK) result = syncPageFile(metadata->file);
+        }
+        free(buffer);
+
+        // (a page of another pool of the shared page table is forced by that pool)
+        BM_BufferPool *owner = (result == RC_IM_KEY_NOT_FOUND) ? findOwner(bm, page->pageNum) : NULL;
+        if (owner != NULL && owner != bm) return forcePage(owner, page);
+        return result;
     }
     else return RC_FILE_HANDLE_NOT_INIT;
 }
@@ -240,51 +1015,149 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
-        HT_TableHandle *pageTabe = &(metadata->pageTable);
-        int frameIndex;
 
         // make sure the pageNum is not negative
         if (pageNum >= 0) 
         {
-            // check if page is already in a frame and get the mapped frameIndex from pageNum
-            if (getValue(pageTabe, pageNum, &frameIndex) == 0)
+            BM_PageTablePartition *partition = getPartition(metadata, pageNum);
+            int frameIndex;
+
+            // a hot page that is already pinned is found and pinned without any latch
+            // (the policy hears about the pin when the page is unpinned)
+            BM_PageFrame *pageFrame = pinOptimistic(bm, pageNum);
+            if (pageFrame != NULL)
+            {
+                metadata->numHits++;
+
+                // (the first pin of a page read ahead moves the read-ahead along)
+                if (pageFrame->prefetched && atomic_exchange(&(pageFrame->prefetched), false))
+                {
+                    pthread_mutex_lock(&(metadata->policyLatch));
+                    readAhead(bm, pageNum, true);
+                    pthread_mutex_unlock(&(metadata->policyLatch));
+                }
+                RC result = waitFrame(pageFrame);
+                if (result != RC_OK)
+                {
+                    dropPin(bm, pageFrame);
+                    return result;
+                }
+                page->data = pageFrame->data;
+                page->pageNum = pageNum;
+                return RC_OK;
+            }
+
+            // otherwise a page that is already pinned can be pinned again under its partition's latch alone
+            // (and is indexed so the next pin can take no latch)
+            pthread_mutex_lock(&(partition->latch));
+            if (getValue(&(partition->table), pageNum, &frameIndex) == 0)
+            {
+                pageFrame = metadata->pageFrames[frameIndex];
+                int fixCount = pageFrame->fixCount;
+                while (fixCount > 0 && !atomic_compare_exchange_weak(&(pageFrame->fixCount), &fixCount, fixCount + 1));
+                if (fixCount == 0) pageFrame = NULL;
+                else indexPage(partition, pageNum, pageFrame);
+            }
+            pthread_mutex_unlock(&(partition->latch));
+
+            // an unpinned page is only pinned under the policy's latch, so the policy never picks a frame that is being pinned
+            pthread_mutex_lock(&(metadata->policyLatch));
+            if (pageFrame == NULL)
+            {
+                pthread_mutex_lock(&(partition->latch));
+                if (getValue(&(partition->table), pageNum, &frameIndex) == 0)
+                {
+                    pageFrame = metadata->pageFrames[frameIndex];
+                    pageFrame->fixCount++;
+                }
+                pthread_mutex_unlock(&(partition->latch));
+            }
+
+            // check if page is already in a frame
+            if (pageFrame != NULL)
             {
-                pageFrames[frameIndex].timeStamp = getTimeStamp(metadata);
-                pageFrames[frameIndex].fixCount++;
-                page->data = pageFrames[frameIndex].data;
+                metadata->numHits++;
+                if (metadata->policy->onHit != NULL)
+                    metadata->policy->onHit(bm, metadata->policyData, pageFrame->frameIndex);
+                readAhead(bm, pageNum, atomic_exchange(&(pageFrame->prefetched), false));
+                pthread_mutex_unlock(&(metadata->policyLatch));
+
+                // another thread may still be reading the page in (and fail to)
+                RC result = waitFrame(pageFrame);
+                if (result != RC_OK)
+                {
+                    dropPin(bm, pageFrame);
+                    return result;
+                }
+                page->data = pageFrame->data;
                 page->pageNum = pageNum;
                 return RC_OK;
             }
             else 
             {
-                // use specified replacement strategy
-                BM_PageFrame *pageFrame;
-                if (bm->strategy == RS_FIFO)
-                    pageFrame = replacementFIFO(bm);
-                else // if (bm->strategy == RS_LRU)
-                    pageFrame = replacementLRU(bm);
-
-                // if the strategy failed (i.e. all frames are pinned) return error
+                // a page another pool of the shared page table caches is pinned in that pool instead
+                // (so it is never cached twice, and this pool's frames are left alone)
+                BM_BufferPool *owner = claimPage(bm, pageNum);
+                if (owner != bm)
+                {
+                    pthread_mutex_unlock(&(metadata->policyLatch));
+                    return pinPage(owner, page, pageNum);
+                }
+
+                // use the pool's replacement policy
+                pageFrame = getVictim(bm);
+
+                // if the policy failed (i.e. all frames are pinned) return error
                 if (pageFrame == NULL)
+                {
+                    releasePage(bm, pageNum);
+                    pthread_mutex_unlock(&(metadata->policyLatch));
                     return RC_WRITE_FAILED;
+                }
                 else 
                 {
-                    // set the mapping from pageNum to frameIndex
-                    setValue(pageTabe, pageNum, pageFrame->frameIndex);
-
                     // grow the file if needed
-                    ensureCapacity(pageNum + 1, &(metadata->pageFile));
+                    RC result = ensureCapacity(pageNum + 1, metadata->file);
 
-                    // read data from disk
-                    readBlock(pageNum, &(metadata->pageFile), pageFrame->data);
-                    metadata->numRead++;
-
-                    // set frame's metadata
+                    // set frame's metadata and the mapping from pageNum to frameIndex, from now on
+                    // threads that pin the page wait for this thread to read it in
                     pageFrame->dirty = false;
                     pageFrame->fixCount = 1;
-                    pageFrame->occupied = true;
+                    pageFrame->state = FRAME_LOADING;
                     pageFrame->pageNum = pageNum;
+                    pthread_mutex_lock(&(partition->latch));
+                    mapPage(partition, pageNum, pageFrame);
+                    pthread_mutex_unlock(&(partition->latch));
+                    metadata->numMisses++;
+                    if (metadata->policy->onLoad != NULL)
+                        metadata->policy->onLoad(bm, metadata->policyData, pageFrame->frameIndex, pageNum);
+                    if (result != RC_OK)
+                    {
+                        failLoad(bm, pageFrame, result);
+                        pthread_mutex_unlock(&(metadata->policyLatch));
+                        return result;
+                    }
+                    readAhead(bm, pageNum, false);
+                    pthread_mutex_unlock(&(metadata->policyLatch));
+
+                    // point into the mapping or read data from disk (without any latch, so misses load in parallel)
+                    if (metadata->mode == SM_MODE_MMAP)
+                        result = mapBlock(pageNum, metadata->file, &(pageFrame->data));
+                    else 
+                    {
+                        result = readBlock(pageNum, metadata->file, pageFrame->data);
+                        if (result == RC_OK) metadata->numRead++;
+                    }
+
+                    // a page that couldn't be read in leaves the pool again
+                    if (result != RC_OK)
+                    {
+                        pthread_mutex_lock(&(metadata->policyLatch));
+                        failLoad(bm, pageFrame, result);
+                        pthread_mutex_unlock(&(metadata->policyLatch));
+                        return result;
+                    }
+                    finishLoad(pageFrame);
                     page->data = pageFrame->data;
                     page->pageNum = pageNum;
                     return RC_OK;
@@ -296,24 +1169,318 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber
     else return RC_FILE_HANDLE_NOT_INIT;
 }
 
-/* Statistics Interface */
+/* Durability */
 
-PageNumber *getFrameContents (BM_BufferPool *const bm)
+RC setFlushPolicy (BM_BufferPool *const bm, SM_SyncPolicy policy, int windowMicros, int windowSize)
 {
     // make sure the metadata was successfully initialized
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
+        return setSyncPolicy(policy, windowMicros, windowSize, metadata->file);
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
 
-        // the user will be responsible for calling free
-        PageNumber *array = (PageNumber *)malloc(sizeof(PageNumber) * bm->numPages);
+RC getFlushSyncStats (BM_BufferPool *const bm, SM_SyncStats *stats)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        return getSyncStats(metadata->file, stats);
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+/* Background Writer */
+
+RC startBackgroundWriter (BM_BufferPool *const bm, int cleanTarget, int intervalMicros)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        BM_BackgroundWriter *writer = &(metadata->writer);
+
+        // mapped pages are written back by the OS, so there is nothing for a writer to do
+        if (cleanTarget <= 0 || intervalMicros <= 0 || metadata->mode == SM_MODE_MMAP || writer->running)
+            return RC_WRITE_FAILED;
+        writer->cleanTarget = cleanTarget;
+        writer->intervalMicros = intervalMicros;
+        writer->scanIndex = 0;
+        writer->stopping = false;
+        writer->frames = (int *)malloc(sizeof(int) * cleanTarget);
+        writer->entries = (BM_FlushEntry *)malloc(sizeof(BM_FlushEntry) * cleanTarget);
+        writer->buffers = (char **)calloc(cleanTarget, sizeof(char *));
+        bool allocated = writer->frames != NULL && writer->entries != NULL && writer->buffers != NULL;
+
+        // the copies are aligned like the frames so they can be written with direct I/O
+        for (int i = 0; allocated && i < cleanTarget; i++)
+        {
+            if (posix_memalign((void **)&(writer->buffers[i]), SM_IO_ALIGNMENT, metadata->file->pageSize) != 0)
+            {
+                writer->buffers[i] = NULL;
+                allocated = false;
+            }
+        }
+        writer->startTime = getSeconds();
+        writer->running = allocated && pthread_create(&(writer->thread), NULL, runBackgroundWriter, bm) == 0;
+        if (!writer->running)
+        {
+            for (int i = 0; writer->buffers != NULL && i < cleanTarget; i++)
+                free(writer->buffers[i]);
+            free(writer->frames);
+            free(writer->entries);
+            free(writer->buffers);
+            return RC_WRITE_FAILED;
+        }
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC stopBackgroundWriter (BM_BufferPool *const bm)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        BM_BackgroundWriter *writer = &(metadata->writer);
+        if (!writer->running)
+            return RC_OK;
+
+        // wake the thread up and wait for it to finish its round
+        pthread_mutex_lock(&(writer->latch));
+        writer->stopping = true;
+        pthread_cond_signal(&(writer->wake));
+        pthread_mutex_unlock(&(writer->latch));
+        pthread_join(writer->thread, NULL);
+        writer->running = false;
+        writer->activeSeconds += getSeconds() - writer->startTime;
+        for (int i = 0; i < writer->cleanTarget; i++)
+            free(writer->buffers[i]);
+        free(writer->frames);
+        free(writer->entries);
+        free(writer->buffers);
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC getWriterStats (BM_BufferPool *const bm, BM_WriterStats *stats)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        BM_BackgroundWriter *writer = &(metadata->writer);
+        pthread_mutex_lock(&(metadata->policyLatch));
+        stats->numFrames = bm->numPages;
+        stats->numDirty = 0;
+        for (int i = 0; i < bm->numPages; i++)
+        {
+            if (metadata->pageFrames[i]->state != FRAME_EMPTY && metadata->pageFrames[i]->dirty)
+                stats->numDirty++;
+        }
+        pthread_mutex_unlock(&(metadata->policyLatch));
+        stats->dirtyRatio = (stats->numFrames > 0) ? (double)stats->numDirty / stats->numFrames : 0;
+        stats->numCleaned = writer->numCleaned;
+        stats->numRounds = writer->numRounds;
+        stats->numEvictionWrites = metadata->numEvictionWrites;
+
+        // the writer's throughput over all the time it has been running
+        double seconds = writer->activeSeconds;
+        if (writer->running)
+            seconds += getSeconds() - writer->startTime;
+        stats->pagesPerSecond = (seconds > 0) ? stats->numCleaned / seconds : 0;
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+/* Shared Page Tables */
+
+RC initSharedPageTable (BM_SharedPageTable *const table)
+{
+    BM_SharedState *shared = (BM_SharedState *)malloc(sizeof(BM_SharedState));
+    table->mgmtData = (void *)shared;
+    if (shared == NULL) return RC_WRITE_FAILED;
+    if (initHashTable(&(shared->owners), 0) != 0)
+    {
+        freeHashTable(&(shared->owners));
+        free(shared);
+        table->mgmtData = NULL;
+        return RC_WRITE_FAILED;
+    }
+    pthread_mutex_init(&(shared->latch), NULL);
+    for (int i = 0; i < BM_MAX_SHARED_POOLS; i++)
+        shared->pools[i] = NULL;
+    shared->numPools = 0;
+    shared->pageFile = NULL;
+    return RC_OK;
+}
+
+RC shutdownSharedPageTable (BM_SharedPageTable *const table)
+{
+    // make sure the shared page table was successfully initialized
+    if (table->mgmtData != NULL)
+    {
+        BM_SharedState *shared = (BM_SharedState *)table->mgmtData;
+
+        // its pools have to be shut down first, then nothing uses the file anymore
+        if (shared->numPools > 0) return RC_WRITE_FAILED;
+        RC result = (shared->pageFile != NULL) ? closeFile(shared->pageFile) : RC_OK;
+        pthread_mutex_destroy(&(shared->latch));
+        freeHashTable(&(shared->owners));
+        free(shared);
+        table->mgmtData = NULL;
+        return result;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC attachBufferPool (BM_BufferPool *const bm, BM_SharedPageTable *const table)
+{
+    // make sure the metadata and shared page table were successfully initialized
+    if (bm->mgmtData != NULL && table->mgmtData != NULL)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        BM_SharedState *shared = (BM_SharedState *)table->mgmtData;
+        RC result = RC_OK;
+        int value;
+        pthread_mutex_lock(&(metadata->policyLatch));
+        pthread_mutex_lock(&(shared->latch));
+
+        // the pool must be over the same file (in the same mode) and not shared yet, and the table must have room for it
+        int poolIndex = -1;
+        for (int i = BM_MAX_SHARED_POOLS - 1; i >= 0; i--)
+        {
+            if (shared->pools[i] == NULL) poolIndex = i;
+        }
+        if (metadata->shared != NULL || poolIndex == -1 || (shared->pageFile != NULL 
+            && (strcmp(shared->pageFile->fileName, metadata->file->fileName) != 0 || shared->mode != metadata->mode)))
+            result = RC_WRITE_FAILED;
+
+        // nor may it cache a page another pool caches (pages are only mapped under the policy's latch)
+        for (int i = 0; result == RC_OK && i < bm->numPages; i++)
+        {
+            if (metadata->pageFrames[i]->state != FRAME_EMPTY 
+                && getValue(&(shared->owners), metadata->pageFrames[i]->pageNum, &value) == 0)
+                result = RC_WRITE_FAILED;
+        }
+
+        // the first pool gives the table its file handle, which all the pools go through from then on, so a page
+        // one of them appends is seen by the others (the handle stays where it is, so reads the pool has in flight
+        // are unaffected, and the other pools keep their own handles open for theirs until they are shut down)
+        if (result == RC_OK && shared->pageFile == NULL)
+        {
+            shared->pageFile = metadata->pageFile;
+            shared->mode = metadata->mode;
+            metadata->pageFile = NULL;
+        }
+        if (result == RC_OK)
+        {
+            for (int i = 0; i < bm->numPages; i++)
+            {
+                if (metadata->pageFrames[i]->state != FRAME_EMPTY)
+                    setValue(&(shared->owners), metadata->pageFrames[i]->pageNum, poolIndex);
+            }
+            metadata->file = shared->pageFile;
+            bm->pageFile = (char *)metadata->file;
+            shared->pools[poolIndex] = bm;
+            shared->numPools++;
+            metadata->shared = table;
+            metadata->sharedIndex = poolIndex;
+        }
+        pthread_mutex_unlock(&(shared->latch));
+        pthread_mutex_unlock(&(metadata->policyLatch));
+        return result;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+/* Read-Ahead */
+
+RC setReadAhead (BM_BufferPool *const bm, int maxWindow)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // mapped pages are faulted in by the OS, which reads ahead on its own
+        if (maxWindow < 0 || (maxWindow > 0 && metadata->mode == SM_MODE_MMAP))
+            return RC_WRITE_FAILED;
+        pthread_mutex_lock(&(metadata->policyLatch));
+        metadata->readAhead.maxWindow = maxWindow;
+        metadata->readAhead.window = READ_AHEAD_MIN_WINDOW;
+        metadata->readAhead.runLength = 0;
+        pthread_mutex_unlock(&(metadata->policyLatch));
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber startPage, int count)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+        // only a hint, so pages that can't be read ahead (mapped, past the end of the file) are left alone
+        if (metadata->mode == SM_MODE_MMAP)
+            return RC_OK;
+        pthread_mutex_lock(&(metadata->policyLatch));
+        for (int i = 0; i < count; i++)
+        {
+            if (prefetchPage(bm, startPage + i) != RC_OK)
+                break;
+        }
+        pthread_mutex_unlock(&(metadata->policyLatch));
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC getReadAheadStats (BM_BufferPool *const bm, BM_ReadAheadStats *stats)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        pthread_mutex_lock(&(metadata->policyLatch));
+        stats->window = (metadata->readAhead.maxWindow > 0) ? metadata->readAhead.window : 0;
+        stats->numPrefetched = metadata->readAhead.numPrefetched;
+        stats->numUsed = metadata->readAhead.numUsed;
+        stats->numWasted = metadata->readAhead.numWasted;
+        pthread_mutex_unlock(&(metadata->policyLatch));
+        return RC_OK;
+    }
+    else return RC_FILE_HANDLE_NOT_INIT;
+}
+
+/* Statistics Interface */
+
+PageNumber *getFrameContents (BM_BufferPool *const bm)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        pthread_mutex_lock(&(metadata->policyLatch));
+        BM_PageFrame **pageFrames = metadata->pageFrames;
+
+        // the user will be responsible for calling free
+        PageNumber *array = (PageNumber *)malloc(sizeof(PageNumber) * bm->numPages);
         for (int i = 0; i < bm->numPages; i++)
         {
-            if (pageFrames[i].occupied)
-                array[i] = pageFrames[i].pageNum;
+            if (pageFrames[i]->state != FRAME_EMPTY)
+                array[i] = pageFrames[i]->pageNum;
             else array[i] = NO_PAGE;
         }
+        pthread_mutex_unlock(&(metadata->policyLatch));
         return array;
     }
     else return NULL;
@@ -325,16 +1492,18 @@ bool *getDirtyFlags (BM_BufferPool *const bm)
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
+        pthread_mutex_lock(&(metadata->policyLatch));
+        BM_PageFrame **pageFrames = metadata->pageFrames;
 
         // the user will be responsible for calling free
         bool *array = (bool *)malloc(sizeof(bool) * bm->numPages);
         for (int i = 0; i < bm->numPages; i++)
         {
-            if (pageFrames[i].occupied)
-                array[i] = pageFrames[i].dirty;
+            if (pageFrames[i]->state != FRAME_EMPTY)
+                array[i] = pageFrames[i]->dirty;
             else array[i] = false;
         }
+        pthread_mutex_unlock(&(metadata->policyLatch));
         return array;
     }
     else return NULL;
@@ -346,16 +1515,18 @@ int *getFixCounts (BM_BufferPool *const bm)
     if (bm->mgmtData != NULL) 
     {
         BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-        BM_PageFrame *pageFrames = metadata->pageFrames;
+        pthread_mutex_lock(&(metadata->policyLatch));
+        BM_PageFrame **pageFrames = metadata->pageFrames;
 
         // the user will be responsible for calling free
         int *array = (int *)malloc(sizeof(int) * bm->numPages);
         for (int i = 0; i < bm->numPages; i++)
         {
-            if (pageFrames[i].occupied)
-                array[i] = pageFrames[i].fixCount;
+            if (pageFrames[i]->state != FRAME_EMPTY)
+                array[i] = pageFrames[i]->fixCount;
             else array[i] = 0;
         }
+        pthread_mutex_unlock(&(metadata->policyLatch));
         return array;
     }
     else return NULL;
@@ -383,87 +1554,1710 @@ int getNumWriteIO (BM_BufferPool *const bm)
     else return 0;
 }
 
+int getNumFlushRuns (BM_BufferPool *const bm)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        return metadata->numFlushRuns;
+    }
+    else return 0;
+}
+
+int getNumHits (BM_BufferPool *const bm)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        return metadata->numHits;
+    }
+    else return 0;
+}
+
+int getNumMisses (BM_BufferPool *const bm)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        return metadata->numMisses;
+    }
+    else return 0;
+}
+
+int getPoolPageSize (BM_BufferPool *const bm)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        return metadata->file->pageSize;
+    }
+    else return 0;
+}
+
+BM_FrameMemory getFrameMemory (BM_BufferPool *const bm)
+{
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL) 
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        return metadata->memory;
+    }
+    else return BM_MEMORY_DEFAULT;
+}
+
 /* Replacement Policies */
 
-BM_PageFrame *replacementFIFO(BM_BufferPool *const bm)
+RC registerReplacementPolicy (const BM_ReplacementPolicy *policy, ReplacementStrategy *strategy)
+{
+    // a policy has to at least be able to pick a victim
+    if (policy == NULL || policy->chooseVictim == NULL)
+        return RC_WRITE_FAILED;
+
+    // take the first free strategy number
+    RC result = RC_WRITE_FAILED;
+    pthread_mutex_lock(&policiesLatch);
+    for (int i = 0; i < RS_MAX_POLICIES; i++)
+    {
+        if (policies[i] == NULL)
+        {
+            policies[i] = policy;
+            *strategy = (ReplacementStrategy)i;
+            result = RC_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&policiesLatch);
+    return result;
+}
+
+const BM_ReplacementPolicy *getReplacementPolicy (ReplacementStrategy strategy)
+{
+    if ((int)strategy < 0 || (int)strategy >= RS_MAX_POLICIES)
+        return NULL;
+    pthread_mutex_lock(&policiesLatch);
+    const BM_ReplacementPolicy *policy = policies[strategy];
+    pthread_mutex_unlock(&policiesLatch);
+    return policy;
+}
+
+int getFrameFixCount (BM_BufferPool *const bm, int frameIndex)
+{
+    // (called by the policy's hooks, which already hold the policy's latch)
+    // make sure the metadata was successfully initialized
+    if (bm->mgmtData != NULL && frameIndex >= 0 && frameIndex < bm->numPages)
+    {
+        BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+        return metadata->pageFrames[frameIndex]->fixCount;
+    }
+    else return 0;
+}
+
+void *initFIFO(BM_BufferPool *const bm, void *stratData)
+{
+    BM_FIFOState *fifo = (BM_FIFOState *)malloc(sizeof(BM_FIFOState));
+
+    // start the queue from the last element as it gets incremented by one and modded 
+    // at the start of each call of replacementFIFO
+    fifo->queueIndex = bm->numPages - 1;
+    return fifo;
+}
+
+int replacementFIFO(BM_BufferPool *const bm, void *policyData)
 {
     BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-    BM_PageFrame *pageFrames = metadata->pageFrames;
+    BM_FIFOState *fifo = (BM_FIFOState *)policyData;
+    BM_PageFrame **pageFrames = metadata->pageFrames;
 
-    int firstIndex = metadata->queueIndex;
-    int currentIndex = metadata->queueIndex;
+    int firstIndex = fifo->queueIndex;
+    int currentIndex = fifo->queueIndex;
 
     // keep cycling in FIFO order until a frame is found that is not pinned
     do 
     {
         currentIndex = (currentIndex + 1) % bm->numPages;
-        if (pageFrames[currentIndex].fixCount == 0)
+        if (pageFrames[currentIndex]->fixCount == 0)
             break;
     }
     while (currentIndex != firstIndex);
 
-    // put the index back into the metadata pointer
-    metadata->queueIndex = currentIndex;
+    // put the index back into the policy's state
+    fifo->queueIndex = currentIndex;
 
-    // ensure we did not cycle into a pinned frame (i.e. all frames are pinned) or return NULL
-    if (pageFrames[currentIndex].fixCount == 0)
-        return getAfterEviction(bm, currentIndex);
-    else return NULL;
+    // ensure we did not cycle into a pinned frame (i.e. all frames are pinned) or return -1
+    if (pageFrames[currentIndex]->fixCount == 0)
+        return currentIndex;
+    else return -1;
+}
+
+void shrinkFIFO(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    // start the queue over if its place is gone
+    BM_FIFOState *fifo = (BM_FIFOState *)policyData;
+    if (fifo->queueIndex >= bm->numPages)
+        fifo->queueIndex = bm->numPages - 1;
 }
 
-BM_PageFrame *replacementLRU(BM_BufferPool *const bm)
+int nextFIFO(BM_BufferPool *const bm, void *policyData, int *frames, int max)
 {
     BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-    BM_PageFrame *pageFrames = metadata->pageFrames;
+    BM_FIFOState *fifo = (BM_FIFOState *)policyData;
+    int count = 0;
+
+    // the unpinned frames after the last victim, in queue order
+    for (int i = 1; i <= bm->numPages && count < max; i++)
+    {
+        int frameIndex = (fifo->queueIndex + i) % bm->numPages;
+        if (metadata->pageFrames[frameIndex]->fixCount == 0)
+            frames[count++] = frameIndex;
+    }
+    return count;
+}
 
-    TimeStamp min = UINT_MAX;
-    int minIndex = -1;
+void *initLRU(BM_BufferPool *const bm, void *stratData)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_FrameList *lru = (BM_FrameList *)malloc(sizeof(BM_FrameList));
+    lru->head = lru->tail = -1;
+    lru->size = 0;
 
-    // find unpinned frame with smallest timestamp
+    // empty frames are the first victims, in order
     for (int i = 0; i < bm->numPages; i++)
+        pushFrame(metadata, lru, i);
+    return lru;
+}
+
+void hitLRU(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    // the list only holds unpinned frames, pinned ones go to the head when they are unpinned
+    unlinkFrame((BM_Metadata *)bm->mgmtData, (BM_FrameList *)policyData, frameIndex);
+}
+
+void accessLRU(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_FrameList *lru = (BM_FrameList *)policyData;
+
+    // move an unpinned frame to the head of the list
+    if (metadata->pageFrames[frameIndex]->fixCount == 0 && lru->head != frameIndex)
     {
-        if (pageFrames[i].fixCount == 0 && pageFrames[i].timeStamp < min) 
-        {
-            min = pageFrames[i].timeStamp;
-            minIndex = i;
-        }
+        unlinkFrame(metadata, lru, frameIndex);
+        pushFrame(metadata, lru, frameIndex);
     }
-    
-    // if all frames were pinned, return NULL
-    if (minIndex == -1) 
-        return NULL;
-    else return getAfterEviction(bm, minIndex);
 }
 
-/* Helpers */
+void unpinLRU(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    // (unpinning an unpinned page only moves it to the head)
+    unlinkFrame((BM_Metadata *)bm->mgmtData, (BM_FrameList *)policyData, frameIndex);
+    pushFrame((BM_Metadata *)bm->mgmtData, (BM_FrameList *)policyData, frameIndex);
+}
 
-TimeStamp getTimeStamp(BM_Metadata *metadata)
+int replacementLRU(BM_BufferPool *const bm, void *policyData)
 {
-    // increment the global timestamp after returning it to be assigned to a frame
-    return metadata->timeStamp++;
+    BM_FrameList *lru = (BM_FrameList *)policyData;
+
+    // only unpinned frames are in the list, the least recently used one is at the tail
+    // (if all frames were pinned, the list is empty and this is -1)
+    int frameIndex = lru->tail;
+    if (frameIndex != -1)
+        unlinkFrame((BM_Metadata *)bm->mgmtData, lru, frameIndex);
+    return frameIndex;
 }
 
-BM_PageFrame *getAfterEviction(BM_BufferPool *const bm, int frameIndex)
+int nextLRU(BM_BufferPool *const bm, void *policyData, int *frames, int max)
+{
+    int count = 0;
+    collectUnpinned((BM_Metadata *)bm->mgmtData, ((BM_FrameList *)policyData)->tail, frames, &count, max, max);
+    return count;
+}
+
+void growLRU(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    // the new frames are unpinned and empty, so they are the next victims (in order)
+    for (int i = bm->numPages - 1; i >= oldNumPages; i--)
+        appendFrame((BM_Metadata *)bm->mgmtData, (BM_FrameList *)policyData, i);
+}
+
+void shrinkLRU(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    dropFrames((BM_Metadata *)bm->mgmtData, (BM_FrameList *)policyData, bm->numPages);
+}
+
+void *initCLOCK(BM_BufferPool *const bm, void *stratData)
+{
+    BM_CLOCKState *clock = (BM_CLOCKState *)malloc(sizeof(BM_CLOCKState));
+    clock->clockHand = bm->numPages - 1;
+    clock->referenced = (bool *)calloc(bm->numPages, sizeof(bool));
+    return clock;
+}
+
+void freeCLOCK(BM_BufferPool *const bm, void *policyData)
+{
+    BM_CLOCKState *clock = (BM_CLOCKState *)policyData;
+    free(clock->referenced);
+    free(clock);
+}
+
+void referenceCLOCK(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    // CLOCK only needs the frame's own bit
+    ((BM_CLOCKState *)policyData)->referenced[frameIndex] = true;
+}
+
+void loadCLOCK(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum)
+{
+    referenceCLOCK(bm, policyData, frameIndex);
+}
+
+int replacementCLOCK(BM_BufferPool *const bm, void *policyData)
 {
     BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
-    BM_PageFrame *pageFrames = metadata->pageFrames;
-    HT_TableHandle *pageTabe = &(metadata->pageTable);
+    BM_CLOCKState *clock = (BM_CLOCKState *)policyData;
+    BM_PageFrame **pageFrames = metadata->pageFrames;
 
-    // update timestamp
-    pageFrames[frameIndex].timeStamp = getTimeStamp(metadata);
-    if (pageFrames[frameIndex].occupied)
+    // sweep the hand around the frames, giving every referenced frame a second chance
+    // after two full turns every unpinned frame has had its bit cleared, so the rest are pinned
+    for (int step = 0; step < 2 * bm->numPages; step++)
     {
-        // remove old mapping
-        removePair(pageTabe, pageFrames[frameIndex].pageNum);
+        clock->clockHand = (clock->clockHand + 1) % bm->numPages;
+        if (pageFrames[clock->clockHand]->fixCount > 0)
+            continue;
+        if (clock->referenced[clock->clockHand])
+            clock->referenced[clock->clockHand] = false;
+        else return clock->clockHand;
+    }
+    return -1;
+}
+
+int nextCLOCK(BM_BufferPool *const bm, void *policyData, int *frames, int max)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_CLOCKState *clock = (BM_CLOCKState *)policyData;
+    int count = 0;
 
-        // write old frame back to disk if dirty
-        if (pageFrames[frameIndex].dirty) 
+    // the hand takes the unreferenced frames on its first turn and the others on its second
+    for (int turn = 0; turn < 2; turn++)
+    {
+        for (int i = 1; i <= bm->numPages && count < max; i++)
         {
-            writeBlock(pageFrames[frameIndex].pageNum, &(metadata->pageFile), pageFrames[frameIndex].data);
-            metadata->numWrite++;
+            int frameIndex = (clock->clockHand + i) % bm->numPages;
+            if (metadata->pageFrames[frameIndex]->fixCount == 0 && clock->referenced[frameIndex] == (turn == 1))
+                frames[count++] = frameIndex;
         }
     }
+    return count;
+}
+
+void growCLOCK(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    BM_CLOCKState *clock = (BM_CLOCKState *)policyData;
+    clock->referenced = (bool *)realloc(clock->referenced, sizeof(bool) * bm->numPages);
+    for (int i = oldNumPages; i < bm->numPages; i++)
+        clock->referenced[i] = false;
+}
+
+void shrinkCLOCK(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    // the hand goes on from the first frame if it was past the last one
+    BM_CLOCKState *clock = (BM_CLOCKState *)policyData;
+    if (clock->clockHand >= bm->numPages)
+        clock->clockHand = bm->numPages - 1;
+}
+
+void *initLRUK(BM_BufferPool *const bm, void *stratData)
+{
+    // K comes from `stratData` (an `int *`)
+    int k = (stratData != NULL) ? *(int *)stratData : LRU_K_DEFAULT;
+    int numPages = bm->numPages;
+    if (k < 1) return NULL;
+
+    BM_LRUKState *lruK = (BM_LRUKState *)malloc(sizeof(BM_LRUKState));
+    lruK->k = k;
+    lruK->clock = 0;
+    lruK->refs = (long *)calloc((size_t)numPages * k, sizeof(long));
+    lruK->numRefs = (int *)calloc(numPages, sizeof(int));
+    initPriorityQueue(&(lruK->victims), numPages);
+
+    // every frame starts out unpinned and empty, so every frame is a victim before any page
+    // (in order, so the frames fill up from the first one)
+    for (int i = 0; i < numPages; i++)
+        setPriority(&(lruK->victims), i, i - numPages);
+
+    // keep the history of as many evicted pages as there are frames
+    lruK->historySize = numPages;
+    lruK->historyNext = 0;
+    initHashTable(&(lruK->historyTable), lruK->historySize);
+    lruK->historyPages = (PageNumber *)malloc(sizeof(PageNumber) * numPages);
+    lruK->historyRefs = (long *)calloc((size_t)numPages * k, sizeof(long));
+    lruK->historyNumRefs = (int *)calloc(numPages, sizeof(int));
+    for (int i = 0; i < numPages; i++)
+        lruK->historyPages[i] = NO_PAGE;
+    return lruK;
+}
+
+void freeLRUK(BM_BufferPool *const bm, void *policyData)
+{
+    BM_LRUKState *lruK = (BM_LRUKState *)policyData;
+    freePriorityQueue(&(lruK->victims));
+    freeHashTable(&(lruK->historyTable));
+    free(lruK->refs);
+    free(lruK->numRefs);
+    free(lruK->historyPages);
+    free(lruK->historyRefs);
+    free(lruK->historyNumRefs);
+    free(lruK);
+}
+
+void hitLRUK(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    referenceLRUK((BM_LRUKState *)policyData, frameIndex);
+}
+
+void unpinLRUK(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    BM_LRUKState *lruK = (BM_LRUKState *)policyData;
+    long *refs = &(lruK->refs[frameIndex * lruK->k]);
+    int numRefs = lruK->numRefs[frameIndex];
+
+    // pages with fewer than K references have an infinite backward K-distance and go first (oldest 
+    // last reference first), then the rest by their K-th most recent reference
+    long priority;
+    if (numRefs == 0) priority = -1;
+    else if (numRefs < lruK->k) priority = refs[0];
+    else priority = (1L << 62) + refs[lruK->k - 1];
+    setPriority(&(lruK->victims), frameIndex, priority);
+}
+
+void loadLRUK(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum)
+{
+    BM_LRUKState *lruK = (BM_LRUKState *)policyData;
+    long *refs = &(lruK->refs[frameIndex * lruK->k]);
+    int slot;
+
+    // a page that was evicted recently picks up the references it had
+    if (getValue(&(lruK->historyTable), pageNum, &slot) == 0)
+    {
+        removePair(&(lruK->historyTable), pageNum);
+        lruK->historyPages[slot] = NO_PAGE;
+        lruK->numRefs[frameIndex] = lruK->historyNumRefs[slot];
+        for (int i = 0; i < lruK->k; i++)
+            refs[i] = lruK->historyRefs[slot * lruK->k + i];
+    }
+    referenceLRUK(lruK, frameIndex);
+}
+
+int replacementLRUK(BM_BufferPool *const bm, void *policyData)
+{
+    BM_LRUKState *lruK = (BM_LRUKState *)policyData;
+    int frameIndex;
+
+    // only unpinned frames are queued, so an empty queue means every frame is pinned
+    if (peekMin(&(lruK->victims), &frameIndex) != 0)
+        return -1;
+    return frameIndex;
+}
+
+int nextLRUK(BM_BufferPool *const bm, void *policyData, int *frames, int max)
+{
+    return peekSmallest(&(((BM_LRUKState *)policyData)->victims), frames, max);
+}
+
+void evictLRUK(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum)
+{
+    BM_LRUKState *lruK = (BM_LRUKState *)policyData;
+
+    // remember the evicted page's references in the history ring
+    if (lruK->numRefs[frameIndex] > 0)
+    {
+        int slot = lruK->historyNext;
+        lruK->historyNext = (slot + 1) % lruK->historySize;
+        if (lruK->historyPages[slot] != NO_PAGE)
+            removePair(&(lruK->historyTable), lruK->historyPages[slot]);
+        lruK->historyPages[slot] = pageNum;
+        lruK->historyNumRefs[slot] = lruK->numRefs[frameIndex];
+        for (int i = 0; i < lruK->k; i++)
+            lruK->historyRefs[slot * lruK->k + i] = lruK->refs[frameIndex * lruK->k + i];
+        setValue(&(lruK->historyTable), pageNum, slot);
+    }
+    lruK->numRefs[frameIndex] = 0;
+}
+
+void growLRUK(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    BM_LRUKState *lruK = (BM_LRUKState *)policyData;
+    lruK->refs = (long *)realloc(lruK->refs, sizeof(long) * bm->numPages * lruK->k);
+    lruK->numRefs = (int *)realloc(lruK->numRefs, sizeof(int) * bm->numPages);
+
+    // the new frames are unpinned and empty, so they are the next victims (in order)
+    for (int i = oldNumPages; i < bm->numPages; i++)
+    {
+        lruK->numRefs[i] = 0;
+        setPriority(&(lruK->victims), i, -1);
+    }
+}
+
+void shrinkLRUK(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    // (the pages that left are in the history already)
+    BM_LRUKState *lruK = (BM_LRUKState *)policyData;
+    for (int i = bm->numPages; i < oldNumPages; i++)
+        removeItem(&(lruK->victims), i);
+}
+
+void referenceLRUK(BM_LRUKState *lruK, int frameIndex)
+{
+    long *refs = &(lruK->refs[frameIndex * lruK->k]);
+
+    // shift the older references down and record this one as the most recent
+    for (int i = lruK->k - 1; i > 0; i--)
+        refs[i] = refs[i - 1];
+    refs[0] = ++(lruK->clock);
+    if (lruK->numRefs[frameIndex] < lruK->k)
+        lruK->numRefs[frameIndex]++;
+
+    // a pinned frame can't be a victim
+    removeItem(&(lruK->victims), frameIndex);
+}
+
+void *initLFU(BM_BufferPool *const bm, void *stratData)
+{
+    // the number of pins between decays comes from `stratData` (an `int *`)
+    int decayInterval = (stratData != NULL) ? *(int *)stratData : LFU_DECAY_DEFAULT * bm->numPages;
+    if (decayInterval < 0) return NULL;
+
+    BM_LFUState *lfu = (BM_LFUState *)malloc(sizeof(BM_LFUState));
+    lfu->counts = (int *)calloc(bm->numPages, sizeof(int));
+    lfu->decayInterval = decayInterval;
+    lfu->sinceDecay = 0;
+    initPriorityQueue(&(lfu->victims), bm->numPages);
+
+    // every frame starts out unpinned and empty, so every frame is a victim before any page
+    for (int i = 0; i < bm->numPages; i++)
+        setPriority(&(lfu->victims), i, -1);
+    return lfu;
+}
+
+void freeLFU(BM_BufferPool *const bm, void *policyData)
+{
+    BM_LFUState *lfu = (BM_LFUState *)policyData;
+    freePriorityQueue(&(lfu->victims));
+    free(lfu->counts);
+    free(lfu);
+}
+
+void hitLFU(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    BM_LFUState *lfu = (BM_LFUState *)policyData;
+    if (lfu->counts[frameIndex] < INT_MAX)
+        lfu->counts[frameIndex]++;
+
+    // a pinned frame can't be a victim
+    removeItem(&(lfu->victims), frameIndex);
+
+    // age every count so pages that were popular a long time ago don't stay forever
+    // (halving keeps the order between frames, the queued ones are decayed the same way)
+    if (lfu->decayInterval > 0 && ++(lfu->sinceDecay) >= lfu->decayInterval)
+    {
+        for (int i = 0; i < bm->numPages; i++)
+            lfu->counts[i] >>= 1;
+        decayPriorities(&(lfu->victims), 1);
+        lfu->sinceDecay = 0;
+    }
+}
+
+void unpinLFU(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    BM_LFUState *lfu = (BM_LFUState *)policyData;
+    setPriority(&(lfu->victims), frameIndex, lfu->counts[frameIndex]);
+}
+
+void loadLFU(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum)
+{
+    hitLFU(bm, policyData, frameIndex);
+}
+
+int replacementLFU(BM_BufferPool *const bm, void *policyData)
+{
+    BM_LFUState *lfu = (BM_LFUState *)policyData;
+    int frameIndex;
+
+    // only unpinned frames are queued, so an empty queue means every frame is pinned
+    if (peekMin(&(lfu->victims), &frameIndex) != 0)
+        return -1;
+    return frameIndex;
+}
+
+int nextLFU(BM_BufferPool *const bm, void *policyData, int *frames, int max)
+{
+    return peekSmallest(&(((BM_LFUState *)policyData)->victims), frames, max);
+}
+
+void evictLFU(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum)
+{
+    // the page that comes in starts counting from scratch
+    ((BM_LFUState *)policyData)->counts[frameIndex] = 0;
+}
+
+void growLFU(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    BM_LFUState *lfu = (BM_LFUState *)policyData;
+    lfu->counts = (int *)realloc(lfu->counts, sizeof(int) * bm->numPages);
+
+    // the new frames are unpinned and empty, so they are the next victims (in order)
+    for (int i = oldNumPages; i < bm->numPages; i++)
+    {
+        lfu->counts[i] = 0;
+        setPriority(&(lfu->victims), i, -1);
+    }
+}
+
+void shrinkLFU(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    BM_LFUState *lfu = (BM_LFUState *)policyData;
+    for (int i = bm->numPages; i < oldNumPages; i++)
+        removeItem(&(lfu->victims), i);
+}
+
+void *init2Q(BM_BufferPool *const bm, void *stratData)
+{
+    // the size of A1in comes from `stratData` (an `int *`)
+    int numPages = bm->numPages;
+    int kIn = (numPages / TWO_Q_IN_SHARE > 0) ? numPages / TWO_Q_IN_SHARE : 1;
+    if (stratData != NULL) kIn = *(int *)stratData;
+    if (kIn < 1) return NULL;
+
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_2QState *twoQ = (BM_2QState *)malloc(sizeof(BM_2QState));
+    twoQ->a1in.head = twoQ->a1in.tail = -1;
+    twoQ->am.head = twoQ->am.tail = -1;
+    twoQ->empty.head = twoQ->empty.tail = -1;
+    twoQ->a1in.size = twoQ->am.size = twoQ->empty.size = 0;
+    twoQ->kIn = kIn;
+    twoQ->hot = (bool *)calloc(numPages, sizeof(bool));
+
+    // every frame starts out empty (in order, so the frames fill up from the first one)
+    for (int i = 0; i < numPages; i++)
+        pushFrame(metadata, &(twoQ->empty), i);
+
+    // remember half as many evicted pages as there are frames
+    twoQ->ghostSize = (numPages / 2 > 0) ? numPages / 2 : 1;
+    twoQ->ghostNext = 0;
+    initHashTable(&(twoQ->ghostTable), twoQ->ghostSize);
+    twoQ->ghostPages = (PageNumber *)malloc(sizeof(PageNumber) * twoQ->ghostSize);
+    for (int i = 0; i < twoQ->ghostSize; i++)
+        twoQ->ghostPages[i] = NO_PAGE;
+    return twoQ;
+}
+
+void free2Q(BM_BufferPool *const bm, void *policyData)
+{
+    BM_2QState *twoQ = (BM_2QState *)policyData;
+    freeHashTable(&(twoQ->ghostTable));
+    free(twoQ->ghostPages);
+    free(twoQ->hot);
+    free(twoQ);
+}
+
+void reference2Q(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_2QState *twoQ = (BM_2QState *)policyData;
+
+    // 2Q only reorders Am, pages in A1in leave in the order they came in however often they are used
+    if (twoQ->hot[frameIndex] && twoQ->am.head != frameIndex)
+    {
+        unlinkFrame(metadata, &(twoQ->am), frameIndex);
+        pushFrame(metadata, &(twoQ->am), frameIndex);
+    }
+}
+
+void load2Q(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_2QState *twoQ = (BM_2QState *)policyData;
+    int slot;
+
+    // a page that is back while A1out still remembers it is used more than once, so it goes to Am
+    // (everything else goes to A1in, which is how a scan passes through without touching Am)
+    if (getValue(&(twoQ->ghostTable), pageNum, &slot) == 0)
+    {
+        removePair(&(twoQ->ghostTable), pageNum);
+        twoQ->ghostPages[slot] = NO_PAGE;
+        twoQ->hot[frameIndex] = true;
+        pushFrame(metadata, &(twoQ->am), frameIndex);
+    }
+    else
+    {
+        twoQ->hot[frameIndex] = false;
+        pushFrame(metadata, &(twoQ->a1in), frameIndex);
+    }
+}
+
+int replacement2Q(BM_BufferPool *const bm, void *policyData)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_2QState *twoQ = (BM_2QState *)policyData;
+
+    // empty frames go first
+    int frameIndex = twoQ->empty.tail;
+    if (frameIndex != -1)
+    {
+        unlinkFrame(metadata, &(twoQ->empty), frameIndex);
+        return frameIndex;
+    }
+
+    // evict the oldest page of A1in while it holds more than its share, else the least recently used page of Am
+    // (both lists keep their pinned frames, which are skipped, and either one is used when the other is all pinned)
+    if (twoQ->a1in.size > twoQ->kIn) 
+        frameIndex = lastUnpinned(metadata, &(twoQ->a1in));
+    if (frameIndex == -1) 
+        frameIndex = lastUnpinned(metadata, &(twoQ->am));
+    if (frameIndex == -1) 
+        frameIndex = lastUnpinned(metadata, &(twoQ->a1in));
+    if (frameIndex == -1) 
+        return -1;
+    unlinkFrame(metadata, twoQ->hot[frameIndex] ? &(twoQ->am) : &(twoQ->a1in), frameIndex);
+    return frameIndex;
+}
+
+int next2Q(BM_BufferPool *const bm, void *policyData, int *frames, int max)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_2QState *twoQ = (BM_2QState *)policyData;
+    int count = 0;
+
+    // the same order as replacement2Q: empty frames, the oldest pages of A1in while it is over its share, Am, the rest of A1in
+    collectUnpinned(metadata, twoQ->empty.tail, frames, &count, max, max);
+    int overShare = (twoQ->a1in.size > twoQ->kIn) ? twoQ->a1in.size - twoQ->kIn : 0;
+    int frameIndex = collectUnpinned(metadata, twoQ->a1in.tail, frames, &count, max, overShare);
+    collectUnpinned(metadata, twoQ->am.tail, frames, &count, max, max);
+    collectUnpinned(metadata, frameIndex, frames, &count, max, max);
+    return count;
+}
+
+void evict2Q(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum)
+{
+    BM_2QState *twoQ = (BM_2QState *)policyData;
+
+    // a page leaving A1in is remembered in A1out so it goes to Am if it comes back soon
+    if (!twoQ->hot[frameIndex])
+    {
+        int slot = twoQ->ghostNext;
+        twoQ->ghostNext = (slot + 1) % twoQ->ghostSize;
+        if (twoQ->ghostPages[slot] != NO_PAGE)
+            removePair(&(twoQ->ghostTable), twoQ->ghostPages[slot]);
+        twoQ->ghostPages[slot] = pageNum;
+        setValue(&(twoQ->ghostTable), pageNum, slot);
+    }
+}
+
+void grow2Q(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    BM_2QState *twoQ = (BM_2QState *)policyData;
+    twoQ->hot = (bool *)realloc(twoQ->hot, sizeof(bool) * bm->numPages);
+    for (int i = oldNumPages; i < bm->numPages; i++)
+    {
+        twoQ->hot[i] = false;
+        pushFrame((BM_Metadata *)bm->mgmtData, &(twoQ->empty), i);
+    }
+}
+
+void shrink2Q(BM_BufferPool *const bm, void *policyData, int oldNumPages)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_2QState *twoQ = (BM_2QState *)policyData;
+    dropFrames(metadata, &(twoQ->empty), bm->numPages);
+    dropFrames(metadata, &(twoQ->a1in), bm->numPages);
+    dropFrames(metadata, &(twoQ->am), bm->numPages);
+}
+
+/* Helpers */
+
+void freePolicyData(BM_BufferPool *const bm, void *policyData)
+{
+    free(policyData);
+}
+
+void pushFrame(BM_Metadata *metadata, BM_FrameList *list, int frameIndex)
+{
+    BM_PageFrame *pageFrame = metadata->pageFrames[frameIndex];
+    pageFrame->lruPrev = -1;
+    pageFrame->lruNext = list->head;
+    if (list->head != -1)
+        metadata->pageFrames[list->head]->lruPrev = frameIndex;
+    else list->tail = frameIndex;
+    list->head = frameIndex;
+    list->size++;
+}
+
+void appendFrame(BM_Metadata *metadata, BM_FrameList *list, int frameIndex)
+{
+    BM_PageFrame *pageFrame = metadata->pageFrames[frameIndex];
+    pageFrame->lruNext = -1;
+    pageFrame->lruPrev = list->tail;
+    if (list->tail != -1)
+        metadata->pageFrames[list->tail]->lruNext = frameIndex;
+    else list->head = frameIndex;
+    list->tail = frameIndex;
+    list->size++;
+}
+
+void unlinkFrame(BM_Metadata *metadata, BM_FrameList *list, int frameIndex)
+{
+    BM_PageFrame *pageFrame = metadata->pageFrames[frameIndex];
+
+    // a frame that is neither linked to another nor the only one in the list isn't in it
+    if (pageFrame->lruPrev == -1 && list->head != frameIndex)
+        return;
+    if (pageFrame->lruPrev != -1)
+        metadata->pageFrames[pageFrame->lruPrev]->lruNext = pageFrame->lruNext;
+    else list->head = pageFrame->lruNext;
+    if (pageFrame->lruNext != -1)
+        metadata->pageFrames[pageFrame->lruNext]->lruPrev = pageFrame->lruPrev;
+    else list->tail = pageFrame->lruPrev;
+    pageFrame->lruPrev = pageFrame->lruNext = -1;
+    list->size--;
+}
+
+void dropFrames(BM_Metadata *metadata, BM_FrameList *list, int numPages)
+{
+    int frameIndex = list->head;
+    while (frameIndex != -1)
+    {
+        int next = metadata->pageFrames[frameIndex]->lruNext;
+        if (frameIndex >= numPages)
+            unlinkFrame(metadata, list, frameIndex);
+        frameIndex = next;
+    }
+}
+
+int lastUnpinned(BM_Metadata *metadata, BM_FrameList *list)
+{
+    int frameIndex = list->tail;
+    while (frameIndex != -1 && metadata->pageFrames[frameIndex]->fixCount > 0)
+        frameIndex = metadata->pageFrames[frameIndex]->lruPrev;
+    return frameIndex;
+}
+
+int collectUnpinned(BM_Metadata *metadata, int frameIndex, int *frames, int *count, int max, int limit)
+{
+    int taken = 0;
+    while (frameIndex != -1 && *count < max && taken < limit)
+    {
+        if (metadata->pageFrames[frameIndex]->fixCount == 0)
+        {
+            frames[(*count)++] = frameIndex;
+            taken++;
+        }
+        frameIndex = metadata->pageFrames[frameIndex]->lruPrev;
+    }
+    return frameIndex;
+}
+
+BM_PageTablePartition *getPartition(BM_Metadata *metadata, PageNumber pageNum)
+{
+    return &(metadata->pageTable[pageNum % PAGE_TABLE_PARTITIONS]);
+}
+
+BM_PageFrame *findFrame(BM_Metadata *metadata, PageNumber pageNum)
+{
+    if (pageNum < 0) return NULL;
+    BM_PageTablePartition *partition = getPartition(metadata, pageNum);
+    BM_PageFrame *pageFrame = NULL;
+    int frameIndex;
+    pthread_mutex_lock(&(partition->latch));
+    if (getValue(&(partition->table), pageNum, &frameIndex) == 0)
+        pageFrame = metadata->pageFrames[frameIndex];
+    pthread_mutex_unlock(&(partition->latch));
+    return pageFrame;
+}
+
+void mapPage(BM_PageTablePartition *partition, PageNumber pageNum, BM_PageFrame *pageFrame)
+{
+    setValue(&(partition->table), pageNum, pageFrame->frameIndex);
+    indexPage(partition, pageNum, pageFrame);
+}
+
+void unmapPage(BM_PageTablePartition *partition, PageNumber pageNum)
+{
+    removePair(&(partition->table), pageNum);
+
+    indexPage(partition, pageNum, NULL);
+}
+
+void indexPage(BM_PageTablePartition *partition, PageNumber pageNum, BM_PageFrame *pageFrame)
+{
+    BM_PageTableSlot *slot = &(partition->slots[(pageNum / PAGE_TABLE_PARTITIONS) % PAGE_TABLE_SLOTS]);
+
+    // leave the slot alone if it is already right (readers can only find a page that is in its slot)
+    if (pageFrame != NULL ? slot->pageNum == pageNum && slot->frame == pageFrame : slot->pageNum != pageNum)
+        return;
+
+    // the version is odd while the slot changes
+    partition->version++;
+    slot->pageNum = (pageFrame != NULL) ? pageNum : NO_PAGE;
+    slot->frame = pageFrame;
+    partition->version++;
+}
+
+BM_PageFrame *pinOptimistic(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_PageTablePartition *partition = getPartition(metadata, pageNum);
+    BM_PageTableSlot *slot = &(partition->slots[(pageNum / PAGE_TABLE_PARTITIONS) % PAGE_TABLE_SLOTS]);
+    for (int i = 0; i < OPTIMISTIC_PIN_RETRIES; i++)
+    {
+        // wait out a writer that is changing the index
+        unsigned version = partition->version;
+        if (version % 2 == 1) continue;
+        BM_PageFrame *pageFrame = slot->frame;
+        if (slot->pageNum != pageNum || pageFrame == NULL)
+        {
+            if (partition->version == version) return NULL;
+            else continue;
+        }
+
+        // pin the frame with one atomic increment, but only if it is pinned already 
+        // (frames are never freed while the pool is up, so this is safe even if the read was torn)
+        int fixCount = pageFrame->fixCount;
+        while (fixCount > 0 && !atomic_compare_exchange_weak(&(pageFrame->fixCount), &fixCount, fixCount + 1));
+        if (fixCount == 0) return NULL;
+
+        // the page can't have left the frame if the index didn't change since it was read
+        if (partition->version == version)
+        {
+            pageFrame->pendingHits++;
+            return pageFrame;
+        }
+
+        // otherwise give the pin back
+        dropPin(bm, pageFrame);
+    }
+    return NULL;
+}
+
+void reportHits(BM_BufferPool *const bm, BM_PageFrame *pageFrame)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    int hits = atomic_exchange(&(pageFrame->pendingHits), 0);
+    if (metadata->policy->onHit != NULL)
+    {
+        for (int i = 0; i < hits; i++)
+            metadata->policy->onHit(bm, metadata->policyData, pageFrame->frameIndex);
+    }
+}
+
+BM_PageFrame *newFrame(BM_Metadata *metadata, int frameIndex)
+{
+    // the pool's first frames are already laid out in its array of frames
+    BM_PageFrame *pageFrame = (frameIndex < metadata->arenaFrames) ? &(metadata->frameArray[frameIndex]) :
+        (BM_PageFrame *)malloc(sizeof(BM_PageFrame));
+    if (pageFrame == NULL) return NULL;
+    pageFrame->frameIndex = frameIndex;
+
+    pageFrame->data = NULL;
+    allocFrameData(metadata, pageFrame);
+    atomic_init(&(pageFrame->fixCount), 0);
+    pageFrame->dirty = false;
+    pageFrame->state = FRAME_EMPTY;
+    atomic_init(&(pageFrame->pendingHits), 0);
+    pageFrame->writing = false;
+    atomic_init(&(pageFrame->prefetched), false);
+    pageFrame->loadResult = RC_OK;
+    pageFrame->lruPrev = pageFrame->lruNext = -1;
+    pthread_mutex_init(&(pageFrame->latch), NULL);
+    pthread_cond_init(&(pageFrame->loaded), NULL);
+    return pageFrame;
+}
+
+RC allocFrameData(BM_Metadata *metadata, BM_PageFrame *pageFrame)
+{
+    // mapped frames point into the page file's mapping once they are occupied
+    // others are aligned so they can be handed to direct I/O without a bounce copy
+    if (metadata->mode == SM_MODE_MMAP || pageFrame->data != NULL) return RC_OK;
+    int slot = arenaSlot(metadata, pageFrame);
+    if (slot != -1)
+    {
+        pageFrame->data = metadata->arena + (size_t)slot * metadata->file->pageSize;
+        return RC_OK;
+    }
+    if (posix_memalign((void **)&(pageFrame->data), SM_IO_ALIGNMENT, metadata->file->pageSize) != 0)
+    {
+        pageFrame->data = NULL;
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+void releaseFrameData(BM_Metadata *metadata, BM_PageFrame *pageFrame)
+{
+    if (metadata->mode == SM_MODE_MMAP || pageFrame->data == NULL) return;
+
+    // a page in the arena can't be freed on its own, but the OS can take its memory back
+    if (arenaSlot(metadata, pageFrame) != -1)
+    {
+        if (metadata->file->pageSize % sysconf(_SC_PAGESIZE) == 0)
+            madvise(pageFrame->data, metadata->file->pageSize, MADV_DONTNEED);
+    }
+    else free(pageFrame->data);
+    pageFrame->data = NULL;
+}
+
+void freeFrame(BM_Metadata *metadata, BM_PageFrame *pageFrame)
+{
+    // free each page frame's data (the arena and array of frames are freed with freeArena)
+    int slot = arenaSlot(metadata, pageFrame);
+    if (metadata->mode != SM_MODE_MMAP && slot == -1) free(pageFrame->data);
+    pthread_mutex_destroy(&(pageFrame->latch));
+    pthread_cond_destroy(&(pageFrame->loaded));
+    if (slot == -1) free(pageFrame);
+}
+
+int arenaSlot(BM_Metadata *metadata, BM_PageFrame *pageFrame)
+{
+    // (a frame's index can change, so its struct's place in the array tells where its page is)
+    if (pageFrame >= metadata->frameArray && pageFrame < metadata->frameArray + metadata->arenaFrames)
+        return (int)(pageFrame - metadata->frameArray);
+    return -1;
+}
+
+RC allocArena(BM_Metadata *metadata, int numPages, BM_FrameMemory memory)
+{
+    metadata->arenaFrames = (numPages > 0) ? numPages : 0;
+    metadata->arena = NULL;
+    metadata->arenaSize = 0;
+    metadata->memory = BM_MEMORY_DEFAULT;
+    metadata->frameArray = (BM_PageFrame *)malloc(sizeof(BM_PageFrame) * (numPages > 0 ? numPages : 1));
+    if (metadata->frameArray == NULL) return RC_WRITE_FAILED;
+
+    // mapped frames point into the page file's mapping instead
+    if (metadata->mode == SM_MODE_MMAP || numPages <= 0) return RC_OK;
+    size_t size = (size_t)numPages * metadata->file->pageSize;
+    size_t hugeSize = (size + ARENA_HUGE_PAGE_SIZE - 1) / ARENA_HUGE_PAGE_SIZE * ARENA_HUGE_PAGE_SIZE;
+
+    // explicit huge pages only exist if they were reserved (vm.nr_hugepages), so fall back to transparent ones
+    if (memory == BM_MEMORY_HUGETLB)
+    {
+        metadata->arena = mapArena(hugeSize, 0, MAP_HUGETLB);
+        if (metadata->arena != NULL)
+        {
+            metadata->arenaSize = hugeSize;
+            metadata->memory = BM_MEMORY_HUGETLB;
+            return RC_OK;
+        }
+        memory = BM_MEMORY_THP;
+    }
+
+    // transparent huge pages need the arena aligned to them (the kernel may still not use them)
+    if (memory == BM_MEMORY_THP)
+    {
+        metadata->arena = mapArena(hugeSize, ARENA_HUGE_PAGE_SIZE, 0);
+        metadata->arenaSize = hugeSize;
+        if (metadata->arena != NULL && madvise(metadata->arena, hugeSize, MADV_HUGEPAGE) == 0)
+            metadata->memory = BM_MEMORY_THP;
+    }
+    else
+    {
+        metadata->arena = mapArena(size, 0, 0);
+        metadata->arenaSize = size;
+    }
+    if (metadata->arena == NULL)
+    {
+        free(metadata->frameArray);
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+// map `size` bytes of anonymous memory, aligned to `alignment` (or just the OS's page) if it isn't 0
+char *mapArena(size_t size, size_t alignment, int flags)
+{
+    char *mapped = mmap(NULL, size + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    if (mapped == MAP_FAILED) return NULL;
+    if (alignment == 0) return mapped;
+
+    // give back what lies before and after the aligned part
+    char *arena = (char *)(((uintptr_t)mapped + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (arena > mapped) munmap(mapped, arena - mapped);
+    if (arena + size < mapped + size + alignment) munmap(arena + size, mapped + size + alignment - (arena + size));
+    return arena;
+}
+
+void freeArena(BM_Metadata *metadata)
+{
+    if (metadata->arena != NULL) munmap(metadata->arena, metadata->arenaSize);
+    free(metadata->frameArray);
+}
+
+RC waitFrame(BM_PageFrame *pageFrame)
+{
+    // (a loaded frame stays loaded while it is pinned, and one whose load failed stays empty)
+    if (pageFrame->state == FRAME_VALID) return RC_OK;
+    pthread_mutex_lock(&(pageFrame->latch));
+    while (pageFrame->state == FRAME_LOADING)
+        pthread_cond_wait(&(pageFrame->loaded), &(pageFrame->latch));
+    RC result = (pageFrame->state == FRAME_VALID) ? RC_OK : pageFrame->loadResult;
+    pthread_mutex_unlock(&(pageFrame->latch));
+    return result;
+}
+
+void dropPin(BM_BufferPool *const bm, BM_PageFrame *pageFrame)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+
+    // (pinned frames are never retired, so the frame is still the policy's, even if its load failed)
+    if (atomic_fetch_sub(&(pageFrame->fixCount), 1) == 1)
+    {
+        pthread_mutex_lock(&(metadata->policyLatch));
+        if (pageFrame->fixCount == 0 && metadata->policy->onUnpin != NULL)
+            metadata->policy->onUnpin(bm, metadata->policyData, pageFrame->frameIndex);
+        pthread_mutex_unlock(&(metadata->policyLatch));
+    }
+}
+
+void waitWrite(BM_PageFrame *pageFrame)
+{
+    pthread_mutex_lock(&(pageFrame->latch));
+    while (pageFrame->writing)
+        pthread_cond_wait(&(pageFrame->loaded), &(pageFrame->latch));
+    pthread_mutex_unlock(&(pageFrame->latch));
+}
+
+int getNextVictims(BM_BufferPool *const bm, int *frames, int max)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    if (metadata->policy->nextVictims != NULL)
+        return metadata->policy->nextVictims(bm, metadata->policyData, frames, max);
+
+    // without the policy's order, go round the frames so every one gets cleaned in time
+    int count = 0;
+    for (int i = 0; i < bm->numPages && count < max; i++)
+    {
+        int frameIndex = (metadata->writer.scanIndex + i) % bm->numPages;
+        if (metadata->pageFrames[frameIndex]->fixCount == 0)
+            frames[count++] = frameIndex;
+    }
+    metadata->writer.scanIndex = (count > 0) ? (frames[count - 1] + 1) % bm->numPages : 0;
+    return count;
+}
+
+void accessFrame(BM_BufferPool *const bm, int frameIndex)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    if (metadata->policy->onAccess != NULL)
+        metadata->policy->onAccess(bm, metadata->policyData, frameIndex);
+}
+
+BM_PageFrame *getVictim(BM_BufferPool *const bm)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    const BM_ReplacementPolicy *policy = metadata->policy;
+    int frameIndex = policy->chooseVictim(bm, metadata->policyData);
+
+    // mapped frames cost nothing so there is no frame limit when all frames are pinned
+    if (frameIndex == -1 && metadata->mode == SM_MODE_MMAP && addFrames(bm, bm->numPages) == RC_OK)
+        frameIndex = policy->chooseVictim(bm, metadata->policyData);
+    if (frameIndex == -1) 
+        return NULL;
+
+    // let the policy know which page is leaving
+    BM_PageFrame *pageFrame = metadata->pageFrames[frameIndex];
+    if (pageFrame->state != FRAME_EMPTY && policy->onEvict != NULL)
+        policy->onEvict(bm, metadata->policyData, frameIndex, pageFrame->pageNum);
+    return getAfterEviction(bm, frameIndex);
+}
+
+BM_PageFrame *getAfterEviction(BM_BufferPool *const bm, int frameIndex)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_PageFrame **pageFrames = metadata->pageFrames;
+
+    // (called under the policy's latch, so nobody can pin the page while it leaves)
+    if (pageFrames[frameIndex]->state != FRAME_EMPTY)
+    {
+        // remove old mapping
+        BM_PageTablePartition *partition = getPartition(metadata, pageFrames[frameIndex]->pageNum);
+        pthread_mutex_lock(&(partition->latch));
+        unmapPage(partition, pageFrames[frameIndex]->pageNum);
+        pthread_mutex_unlock(&(partition->latch));
+        pageFrames[frameIndex]->pendingHits = 0;
+
+        // a page read ahead for nothing means the scan went elsewhere, so read less ahead
+        if (atomic_exchange(&(pageFrames[frameIndex]->prefetched), false))
+        {
+            metadata->readAhead.numWasted++;
+            metadata->readAhead.window = (metadata->readAhead.window / 2 > READ_AHEAD_MIN_WINDOW) ?
+                metadata->readAhead.window / 2 : READ_AHEAD_MIN_WINDOW;
+        }
+
+        // the page can't be read back in before a copy that is being written is on disk
+        waitWrite(pageFrames[frameIndex]);
+
+        // write old frame back to disk if dirty (mapped frames are written back by the OS)
+        if (pageFrames[frameIndex]->dirty && metadata->mode != SM_MODE_MMAP) 
+        {
+            writeBlock(pageFrames[frameIndex]->pageNum, metadata->file, pageFrames[frameIndex]->data);
+            metadata->numWrite++;
+            metadata->numEvictionWrites++;
+
+            // the writer is falling behind, so don't let it sleep out its interval
+            if (metadata->writer.running)
+                pthread_cond_signal(&(metadata->writer.wake));
+        }
+
+        // other pools of the shared page table can read the page in from now on
+        releasePage(bm, pageFrames[frameIndex]->pageNum);
+    }
 
     // return evicted frame (called must deal with setting the page's metadata)
-    return &(pageFrames[frameIndex]);
-}
\ No newline at end of file
+    return pageFrames[frameIndex];
+}
+
+int cleanFrames(BM_BufferPool *const bm)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_BackgroundWriter *writer = &(metadata->writer);
+    BM_PageFrame **pageFrames;
+    int numEntries = 0;
+    int numWritten = 0;
+
+    // find the dirty pages among the next `cleanTarget` victims and copy them while nobody holds a pin
+    // (a thread that pins one afterwards marks it dirty again if it changes it)
+    pthread_mutex_lock(&(metadata->policyLatch));
+    pageFrames = metadata->pageFrames;
+    int numFrames = getNextVictims(bm, writer->frames, writer->cleanTarget);
+    for (int i = 0; i < numFrames; i++)
+    {
+        BM_PageFrame *pageFrame = pageFrames[writer->frames[i]];
+        if (pageFrame->state == FRAME_VALID && pageFrame->dirty && pageFrame->fixCount == 0 && !pageFrame->writing)
+        {
+            writer->entries[numEntries].pageNum = pageFrame->pageNum;
+            writer->entries[numEntries].frameIndex = pageFrame->frameIndex;
+            writer->entries[numEntries].pageFrame = pageFrame;
+            numEntries++;
+        }
+    }
+    qsort(writer->entries, numEntries, sizeof(BM_FlushEntry), compareFlushEntries);
+    for (int i = 0; i < numEntries; i++)
+        startWrite(metadata, writer->entries[i].pageFrame, writer->buffers[i]);
+    pthread_mutex_unlock(&(metadata->policyLatch));
+
+    // write each run of contiguous pages with a single vectored write, without any latch
+    RC result = RC_OK;
+    numWritten = writeCopies(bm, writer->entries, writer->buffers, numEntries, NULL, &result);
+    writer->numCleaned += numWritten;
+    return numWritten;
+}
+
+void startWrite(BM_Metadata *metadata, BM_PageFrame *pageFrame, char *buffer)
+{
+    if (buffer != NULL)
+        memcpy(buffer, pageFrame->data, metadata->file->pageSize);
+    pageFrame->dirty = false;
+    pthread_mutex_lock(&(pageFrame->latch));
+    pageFrame->writing = true;
+    pthread_mutex_unlock(&(pageFrame->latch));
+}
+
+int writeCopies(BM_BufferPool *const bm, BM_FlushEntry *entries, char **buffers, int count, atomic_int *numRuns, RC *result)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    int numWritten = 0;
+    int runStart = 0;
+    while (runStart < count)
+    {
+        int runLength = 1;
+        while (runStart + runLength < count && entries[runStart + runLength].pageNum == entries[runStart].pageNum + runLength)
+            runLength++;
+
+        // mapped pages are already in the file's mapping and only need to be synced
+        RC runResult;
+        if (metadata->mode == SM_MODE_MMAP)
+            runResult = syncBlocks(entries[runStart].pageNum, runLength, metadata->file);
+        else runResult = writeBlocks(entries[runStart].pageNum, runLength, metadata->file, &(buffers[runStart]));
+        if (numRuns != NULL) 
+            (*numRuns)++;
+        if (runResult == RC_OK)
+        {
+            metadata->numWrite += runLength;
+            numWritten += runLength;
+        }
+        else *result = runResult;
+
+        // the frames can be evicted again (and are still dirty if the write failed)
+        for (int i = runStart; i < runStart + runLength; i++)
+        {
+            BM_PageFrame *pageFrame = entries[i].pageFrame;
+            pthread_mutex_lock(&(pageFrame->latch));
+            if (runResult != RC_OK) pageFrame->dirty = true;
+            pageFrame->writing = false;
+            pthread_cond_broadcast(&(pageFrame->loaded));
+            pthread_mutex_unlock(&(pageFrame->latch));
+        }
+        runStart += runLength;
+    }
+    return numWritten;
+}
+
+void *runBackgroundWriter(void *arg)
+{
+    BM_BufferPool *bm = (BM_BufferPool *)arg;
+    BM_BackgroundWriter *writer = &(((BM_Metadata *)bm->mgmtData)->writer);
+    pthread_mutex_lock(&(writer->latch));
+    while (!writer->stopping)
+    {
+        pthread_mutex_unlock(&(writer->latch));
+        int numWritten = cleanFrames(bm);
+        writer->numRounds++;
+        pthread_mutex_lock(&(writer->latch));
+
+        // go again right away while there is something to write, else sleep until the interval is up
+        // (or an eviction had to write a dirty page)
+        if (numWritten == 0 && !writer->stopping)
+        {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            long nanos = deadline.tv_nsec + (long)writer->intervalMicros * 1000;
+            deadline.tv_sec += nanos / 1000000000;
+            deadline.tv_nsec = nanos % 1000000000;
+            pthread_cond_timedwait(&(writer->wake), &(writer->latch), &deadline);
+        }
+    }
+    pthread_mutex_unlock(&(writer->latch));
+    return NULL;
+}
+
+void readAhead(BM_BufferPool *const bm, PageNumber pageNum, bool prefetched)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_ReadAhead *ra = &(metadata->readAhead);
+
+    // every page read ahead that is used lets the window grow by one
+    if (prefetched)
+    {
+        ra->numUsed++;
+        if (ra->window < ra->maxWindow && ra->window < bm->numPages / 4)
+            ra->window++;
+    }
+    if (ra->maxWindow == 0)
+        return;
+
+    // a pin of the page after the last one continues the run, any other starts a new one with the smallest window
+    if (pageNum == ra->lastPage + 1)
+        ra->runLength++;
+    else if (pageNum != ra->lastPage)
+    {
+        ra->runLength = 1;
+        ra->window = READ_AHEAD_MIN_WINDOW;
+    }
+    ra->lastPage = pageNum;
+    if (ra->runLength < READ_AHEAD_TRIGGER)
+        return;
+
+    // keep the window's pages ahead of the scan in the pool (never more than a quarter of it, so pins always find a frame)
+    int window = (ra->window < bm->numPages / 4) ? ra->window : bm->numPages / 4;
+    for (int i = 1; i <= window; i++)
+    {
+        if (prefetchPage(bm, pageNum + i) != RC_OK)
+            break;
+    }
+}
+
+RC prefetchPage(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_ReadAhead *ra = &(metadata->readAhead);
+
+    // only pages of the file that aren't in the pool yet
+    if (pageNum < 0 || pageNum >= metadata->file->totalNumPages)
+        return RC_READ_NON_EXISTING_PAGE;
+    if (findFrame(metadata, pageNum) != NULL)
+        return RC_OK;
+    if (!ra->started)
+    {
+        if (initAsyncIO(&(ra->engine), READ_AHEAD_THREADS) != RC_OK)
+            return RC_WRITE_FAILED;
+        ra->started = true;
+    }
+
+    // never evict a page read ahead that wasn't used yet to read another one (the scan hasn't caught up)
+    int next;
+    if (metadata->policy->nextVictims != NULL && metadata->policy->nextVictims(bm, metadata->policyData, &next, 1) == 1
+        && metadata->pageFrames[next]->prefetched)
+        return RC_WRITE_FAILED;
+    BM_Prefetch *prefetch = (BM_Prefetch *)malloc(sizeof(BM_Prefetch));
+    if (prefetch == NULL)
+        return RC_WRITE_FAILED;
+
+    // (nor in another pool of the shared page table)
+    if (claimPage(bm, pageNum) != bm)
+    {
+        free(prefetch);
+        return RC_OK;
+    }
+    BM_PageFrame *pageFrame = getVictim(bm);
+    if (pageFrame == NULL)
+    {
+        releasePage(bm, pageNum);
+        free(prefetch);
+        return RC_WRITE_FAILED;
+    }
+
+    // the page is mapped as loading (like a miss) and the read holds a pin until it completes
+    pageFrame->dirty = false;
+    pageFrame->fixCount = 1;
+    pageFrame->state = FRAME_LOADING;
+    pageFrame->pageNum = pageNum;
+    pageFrame->prefetched = true;
+    BM_PageTablePartition *partition = getPartition(metadata, pageNum);
+    pthread_mutex_lock(&(partition->latch));
+    mapPage(partition, pageNum, pageFrame);
+    pthread_mutex_unlock(&(partition->latch));
+    if (metadata->policy->onLoad != NULL)
+        metadata->policy->onLoad(bm, metadata->policyData, pageFrame->frameIndex, pageNum);
+    ra->numPrefetched++;
+    prefetch->bm = bm;
+    prefetch->pageFrame = pageFrame;
+    prefetch->buffers[0] = pageFrame->data;
+    if (asyncReadBlocks(&(ra->engine), &(prefetch->request), pageNum, 1, metadata->file,
+        prefetch->buffers, completePrefetch, prefetch) != RC_OK)
+    {
+        // read it here instead (the policy's latch is held, so the pin is given back without it)
+        RC result = readBlock(pageNum, metadata->file, pageFrame->data);
+        free(prefetch);
+        if (result != RC_OK)
+        {
+            failLoad(bm, pageFrame, result);
+            return result;
+        }
+        metadata->numRead++;
+        finishLoad(pageFrame);
+        if (--pageFrame->fixCount == 0 && metadata->policy->onUnpin != NULL)
+            metadata->policy->onUnpin(bm, metadata->policyData, pageFrame->frameIndex);
+    }
+    return RC_OK;
+}
+
+void completePrefetch(AIO_Request *request)
+{
+    BM_Prefetch *prefetch = (BM_Prefetch *)request->userData;
+    BM_BufferPool *bm = prefetch->bm;
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_PageFrame *pageFrame = prefetch->pageFrame;
+    RC result = request->result;
+    free(prefetch);
+
+    // a page that couldn't be read ahead leaves the pool again (with the read's pin)
+    if (result != RC_OK)
+    {
+        pthread_mutex_lock(&(metadata->policyLatch));
+        failLoad(bm, pageFrame, result);
+        pthread_mutex_unlock(&(metadata->policyLatch));
+        return;
+    }
+    metadata->numRead++;
+    finishLoad(pageFrame);
+
+    // give the read's pin back, telling the policy if it was the last one
+    if (atomic_fetch_sub(&(pageFrame->fixCount), 1) == 1)
+    {
+        pthread_mutex_lock(&(metadata->policyLatch));
+        reportHits(bm, pageFrame);
+        if (pageFrame->fixCount == 0 && pageFrame->state != FRAME_EMPTY && metadata->policy->onUnpin != NULL)
+            metadata->policy->onUnpin(bm, metadata->policyData, pageFrame->frameIndex);
+        pthread_mutex_unlock(&(metadata->policyLatch));
+    }
+}
+
+void finishLoad(BM_PageFrame *pageFrame)
+{
+    pthread_mutex_lock(&(pageFrame->latch));
+    pageFrame->state = FRAME_VALID;
+    pthread_cond_broadcast(&(pageFrame->loaded));
+    pthread_mutex_unlock(&(pageFrame->latch));
+}
+
+void failLoad(BM_BufferPool *const bm, BM_PageFrame *pageFrame, RC result)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_PageTablePartition *partition = getPartition(metadata, pageFrame->pageNum);
+
+    // the page leaves as if it was evicted (with nothing to write back), so the next pin reads it again
+    if (metadata->policy->onEvict != NULL)
+        metadata->policy->onEvict(bm, metadata->policyData, pageFrame->frameIndex, pageFrame->pageNum);
+    pthread_mutex_lock(&(partition->latch));
+    unmapPage(partition, pageFrame->pageNum);
+    pthread_mutex_unlock(&(partition->latch));
+    pageFrame->dirty = false;
+    pageFrame->prefetched = false;
+    releasePage(bm, pageFrame->pageNum);
+
+    // wake up the threads waiting for the page, which give their pins back
+    pthread_mutex_lock(&(pageFrame->latch));
+    pageFrame->loadResult = result;
+    pageFrame->state = FRAME_EMPTY;
+    pthread_cond_broadcast(&(pageFrame->loaded));
+    pthread_mutex_unlock(&(pageFrame->latch));
+
+    // the frame is a victim again once the last pin is given back
+    if (atomic_fetch_sub(&(pageFrame->fixCount), 1) == 1 && metadata->policy->onUnpin != NULL)
+        metadata->policy->onUnpin(bm, metadata->policyData, pageFrame->frameIndex);
+}
+
+BM_BufferPool *claimPage(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    if (metadata->shared == NULL) return bm;
+    BM_SharedState *shared = (BM_SharedState *)metadata->shared->mgmtData;
+    BM_BufferPool *owner = bm;
+    int poolIndex;
+    pthread_mutex_lock(&(shared->latch));
+    if (getValue(&(shared->owners), pageNum, &poolIndex) == 0)
+        owner = shared->pools[poolIndex];
+    else setValue(&(shared->owners), pageNum, metadata->sharedIndex);
+    pthread_mutex_unlock(&(shared->latch));
+    return owner;
+}
+
+void releasePage(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    if (metadata->shared == NULL) return;
+    BM_SharedState *shared = (BM_SharedState *)metadata->shared->mgmtData;
+    int poolIndex;
+    pthread_mutex_lock(&(shared->latch));
+    if (getValue(&(shared->owners), pageNum, &poolIndex) == 0 && poolIndex == metadata->sharedIndex)
+        removePair(&(shared->owners), pageNum);
+    pthread_mutex_unlock(&(shared->latch));
+}
+
+BM_BufferPool *findOwner(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    if (metadata->shared == NULL) return NULL;
+    BM_SharedState *shared = (BM_SharedState *)metadata->shared->mgmtData;
+    BM_BufferPool *owner = NULL;
+    int poolIndex;
+    pthread_mutex_lock(&(shared->latch));
+    if (getValue(&(shared->owners), pageNum, &poolIndex) == 0)
+        owner = shared->pools[poolIndex];
+    pthread_mutex_unlock(&(shared->latch));
+    return owner;
+}
+
+void detachBufferPool(BM_BufferPool *const bm)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    if (metadata->shared == NULL) return;
+    BM_SharedState *shared = (BM_SharedState *)metadata->shared->mgmtData;
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        if (metadata->pageFrames[i]->state != FRAME_EMPTY)
+            releasePage(bm, metadata->pageFrames[i]->pageNum);
+    }
+    pthread_mutex_lock(&(shared->latch));
+    shared->pools[metadata->sharedIndex] = NULL;
+    shared->numPools--;
+    pthread_mutex_unlock(&(shared->latch));
+    metadata->shared = NULL;
+}
+
+SM_FileHandle *openFile(const char *fileName, SM_FileMode mode, RC *result)
+{
+    // the handle keeps a copy of the name, since it may outlive the pool (see attachBufferPool)
+    SM_FileHandle *fHandle = (SM_FileHandle *)malloc(sizeof(SM_FileHandle));
+    char *name = strdup(fileName);
+    *result = (fHandle != NULL && name != NULL) ? openPageFileMode(name, fHandle, mode) : RC_WRITE_FAILED;
+    if (*result == RC_OK) return fHandle;
+    free(name);
+    free(fHandle);
+    return NULL;
+}
+
+RC closeFile(SM_FileHandle *fHandle)
+{
+    RC result = closePageFile(fHandle);
+    free(fHandle->fileName);
+    free(fHandle);
+    return result;
+}
+
+double getSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int compareFlushEntries(const void *a, const void *b)
+{
+    PageNumber left = ((const BM_FlushEntry *)a)->pageNum;
+    PageNumber right = ((const BM_FlushEntry *)b)->pageNum;
+    return (left > right) - (left < right);
+}
+
+RC addFrames(BM_BufferPool *const bm, int count)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    int oldNumPages = bm->numPages;
+    int numPages = bm->numPages + count;
+
+    // frames a shrink retired come back first (they only need their memory back)
+    int numReused = (metadata->numFrames - oldNumPages < count) ? metadata->numFrames - oldNumPages : count;
+    for (int i = oldNumPages; i < oldNumPages + numReused; i++)
+    {
+        if (allocFrameData(metadata, metadata->pageFrames[i]) != RC_OK) return RC_WRITE_FAILED;
+    }
+
+    // set up the new frames as empty
+    int numNew = count - numReused;
+    BM_PageFrame **newFrames = (BM_PageFrame **)malloc(sizeof(BM_PageFrame *) * (numNew > 0 ? numNew : 1));
+    if (newFrames == NULL) return RC_WRITE_FAILED;
+    for (int i = 0; i < numNew; i++)
+        newFrames[i] = newFrame(metadata, metadata->numFrames + i);
+
+    // other threads only look at the array of frames under the policy's latch (held by the caller) 
+    // or a partition's latch, so hold all of those while it moves
+    for (int i = 0; i < PAGE_TABLE_PARTITIONS; i++)
+        pthread_mutex_lock(&(metadata->pageTable[i].latch));
+    BM_PageFrame **pageFrames = metadata->pageFrames;
+    if (numNew > 0)
+        pageFrames = (BM_PageFrame **)realloc(metadata->pageFrames, sizeof(BM_PageFrame *) * numPages);
+    if (pageFrames != NULL)
+    {
+        for (int i = 0; i < numNew; i++)
+            pageFrames[metadata->numFrames + i] = newFrames[i];
+        metadata->pageFrames = pageFrames;
+        metadata->numFrames += numNew;
+        bm->numPages = numPages;
+    }
+    for (int i = PAGE_TABLE_PARTITIONS - 1; i >= 0; i--)
+        pthread_mutex_unlock(&(metadata->pageTable[i].latch));
+    if (pageFrames == NULL)
+    {
+        for (int i = 0; i < numNew; i++)
+            freeFrame(metadata, newFrames[i]);
+        free(newFrames);
+        return RC_WRITE_FAILED;
+    }
+    free(newFrames);
+
+    // the policy picks the victim among the new frames itself
+    if (metadata->policy->onGrow != NULL)
+        metadata->policy->onGrow(bm, metadata->policyData, oldNumPages);
+    return RC_OK;
+}
+
+RC removeFrames(BM_BufferPool *const bm, int count)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    const BM_ReplacementPolicy *policy = metadata->policy;
+    int oldNumPages = bm->numPages;
+    int numPages = bm->numPages - count;
+    if (policy->onShrink == NULL) return RC_WRITE_FAILED;
+
+    // a pinned page can't be evicted, and its handle points into its frame, so a pinned frame that would go
+    // moves to the index of a victim that stays instead (there must be one for each of them)
+    int *victims = (int *)malloc(sizeof(int) * oldNumPages);
+    int *moving = (int *)malloc(sizeof(int) * count);
+    if (victims == NULL || moving == NULL)
+    {
+        free(victims);
+        free(moving);
+        return RC_WRITE_FAILED;
+    }
+    int numVictims = 0;
+    int numPinned = 0;
+    int numFound = getNextVictims(bm, victims, oldNumPages);
+    for (int i = 0; i < numFound; i++)
+    {
+        if (victims[i] < numPages) numVictims++;
+    }
+    for (int i = numPages; i < oldNumPages; i++)
+    {
+        if (metadata->pageFrames[i]->fixCount > 0) numPinned++;
+    }
+    free(victims);
+    if (numVictims < numPinned)
+    {
+        free(moving);
+        return RC_WRITE_FAILED;
+    }
+
+    // evict the pages of the frames that go, writing the dirty ones back (under the policy's latch unpinned 
+    // frames stay unpinned, but pinned ones may be unpinned, which only leaves less to move)
+    int numMoving = 0;
+    for (int i = numPages; i < oldNumPages; i++)
+    {
+        BM_PageFrame *pageFrame = metadata->pageFrames[i];
+        if (pageFrame->state != FRAME_EMPTY && policy->onEvict != NULL)
+            policy->onEvict(bm, metadata->policyData, i, pageFrame->pageNum);
+        if (pageFrame->fixCount > 0)
+        {
+            moving[numMoving++] = i;
+            continue;
+        }
+        getAfterEviction(bm, i);
+        pageFrame->dirty = false;
+        pageFrame->state = FRAME_EMPTY;
+    }
+
+    // the policy forgets the frames that go, so it only picks victims among the ones that stay
+    bm->numPages = numPages;
+    policy->onShrink(bm, metadata->policyData, oldNumPages);
+
+    // each pinned page moves (with its frame) into a victim, as if it was read into it
+    // (the victims counted above are still there, since nothing is pinned or unpinned under the latch)
+    for (int i = 0; i < numMoving; i++)
+    {
+        int frameIndex = policy->chooseVictim(bm, metadata->policyData);
+        BM_PageFrame *victim = metadata->pageFrames[frameIndex];
+        if (victim->state != FRAME_EMPTY && policy->onEvict != NULL)
+            policy->onEvict(bm, metadata->policyData, frameIndex, victim->pageNum);
+        getAfterEviction(bm, frameIndex);
+        victim->dirty = false;
+        victim->state = FRAME_EMPTY;
+        moveFrame(bm, moving[i], frameIndex);
+        if (metadata->pageFrames[frameIndex]->state != FRAME_EMPTY && policy->onLoad != NULL)
+            policy->onLoad(bm, metadata->policyData, frameIndex, metadata->pageFrames[frameIndex]->pageNum);
+    }
+    free(moving);
+
+    // retire the frames, giving their memory back (the frames themselves stay until shutdown)
+    for (int i = numPages; i < oldNumPages; i++)
+        releaseFrameData(metadata, metadata->pageFrames[i]);
+    return RC_OK;
+}
+
+void moveFrame(BM_BufferPool *const bm, int from, int to)
+{
+    BM_Metadata *metadata = (BM_Metadata *)bm->mgmtData;
+    BM_PageFrame *pageFrame = metadata->pageFrames[from];
+    BM_PageFrame *emptyFrame = metadata->pageFrames[to];
+
+    // the frames swap places but not their places in the policy's lists, which belong to the index
+    int lruPrev = pageFrame->lruPrev;
+    int lruNext = pageFrame->lruNext;
+    pageFrame->lruPrev = emptyFrame->lruPrev;
+    pageFrame->lruNext = emptyFrame->lruNext;
+    emptyFrame->lruPrev = lruPrev;
+    emptyFrame->lruNext = lruNext;
+
+    // threads only look a page's frame up by its index under a partition's latch, so hold all of them while
+    // it changes (the lock-free index points at the frame itself, which stays the same)
+    for (int i = 0; i < PAGE_TABLE_PARTITIONS; i++)
+        pthread_mutex_lock(&(metadata->pageTable[i].latch));
+    metadata->pageFrames[to] = pageFrame;
+    metadata->pageFrames[from] = emptyFrame;
+    pageFrame->frameIndex = to;
+    emptyFrame->frameIndex = from;
+    // (a frame that is only pinned by threads waiting for a load that failed has no page)
+    if (pageFrame->state != FRAME_EMPTY)
+        mapPage(getPartition(metadata, pageFrame->pageNum), pageFrame->pageNum, pageFrame);
+    for (int i = PAGE_TABLE_PARTITIONS - 1; i >= 0; i--)
+        pthread_mutex_unlock(&(metadata->pageTable[i].latch));
+}
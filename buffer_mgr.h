@@ -7,15 +7,32 @@
 // Include bool DT
 #include "dt.h"
 
+// Include the page file modes
+#include "storage_mgr.h"
+
 // Replacement Strategies
 typedef enum ReplacementStrategy {
 	RS_FIFO = 0,
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_2Q = 5
 } ReplacementStrategy;
 
+// the number of replacement strategies that can be registered (the built-in ones included)
+#define RS_MAX_POLICIES 16
+
+// where the memory of a pool's frames comes from (see initBufferPoolMemory)
+typedef enum BM_FrameMemory {
+	BM_MEMORY_DEFAULT = 0,
+	BM_MEMORY_THP = 1,     // transparent huge pages
+	BM_MEMORY_HUGETLB = 2  // explicit huge pages (falling back to transparent ones)
+} BM_FrameMemory;
+
+// the number of pools that can share one page table
+#define BM_MAX_SHARED_POOLS 16
+
 // Data Types and Structures
 typedef int PageNumber;
 #define NO_PAGE -1
@@ -33,6 +50,30 @@ typedef struct BM_PageHandle {
 	char *data;
 } BM_PageHandle;
 
+// a page table shared by pools over the same page file, so a page is never cached in two of them
+typedef struct BM_SharedPageTable {
+	void *mgmtData;
+} BM_SharedPageTable;
+
+// counters kept for the background writer
+typedef struct BM_WriterStats {
+	int numFrames;
+	int numDirty;          // dirty frames right now
+	double dirtyRatio;     // numDirty / numFrames
+	long numCleaned;       // pages written by the writer
+	long numRounds;        // times the writer woke up
+	long numEvictionWrites; // dirty victims pinPage had to write itself
+	double pagesPerSecond; // numCleaned over the time the writer has been running
+} BM_WriterStats;
+
+// counters kept for read-ahead
+typedef struct BM_ReadAheadStats {
+	int window;            // pages read ahead of a sequential scan right now
+	long numPrefetched;    // pages read ahead
+	long numUsed;          // pages read ahead that were pinned
+	long numWasted;        // pages read ahead that were evicted without a pin
+} BM_ReadAheadStats;
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -40,12 +81,55 @@ typedef struct BM_PageHandle {
 #define MAKE_PAGE_HANDLE()				\
 		((BM_PageHandle *) malloc (sizeof(BM_PageHandle)))
 
+// Replacement Policies
+// a policy is a set of hooks the buffer manager calls, `policyData` is whatever `init` returned
+// frames are identified by their index (0 to bm->numPages - 1) and every hook but `chooseVictim` may be NULL
+typedef struct BM_ReplacementPolicy {
+	char *name;
+	// set up the policy's state for bm->numPages empty frames, NULL if `stratData` isn't valid
+	void *(*init)(BM_BufferPool *const bm, void *stratData);
+	// free the policy's state
+	void (*shutdown)(BM_BufferPool *const bm, void *policyData);
+	// the page in the frame was pinned again (a pin of a page that was already pinned is reported when the page is unpinned)
+	void (*onHit)(BM_BufferPool *const bm, void *policyData, int frameIndex);
+	// the page in the frame was used without a pin (markDirty, forcePage, forceFlushPool, or an unpin that leaves it pinned)
+	void (*onAccess)(BM_BufferPool *const bm, void *policyData, int frameIndex);
+	// the frame's fix count is 0 after an unpin
+	void (*onUnpin)(BM_BufferPool *const bm, void *policyData, int frameIndex);
+	// a page was brought into the frame and pinned once
+	void (*onLoad)(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
+	// return the unpinned frame to reuse, or -1 if every frame is pinned
+	int (*chooseVictim)(BM_BufferPool *const bm, void *policyData);
+	// the page is about to leave the chosen frame (not called for empty frames)
+	void (*onEvict)(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum);
+	// the pool grew from `oldNumPages` to bm->numPages frames, the new ones empty (resizeBufferPool, or SM_MODE_MMAP 
+	// when every frame is pinned)
+	void (*onGrow)(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+	// the pool shrank from `oldNumPages` to bm->numPages frames, the frames that went were empty and unpinned
+	// (their pages were evicted through `onEvict`), a policy without it can't be shrunk
+	void (*onShrink)(BM_BufferPool *const bm, void *policyData, int oldNumPages);
+	// fill `frames` with (up to `max`) unpinned frames in the order they would be chosen, without changing the
+	// policy's state, and return how many there are (used by the background writer, which scans all frames without it)
+	int (*nextVictims)(BM_BufferPool *const bm, void *policyData, int *frames, int max);
+} BM_ReplacementPolicy;
+
+RC registerReplacementPolicy (const BM_ReplacementPolicy *policy, ReplacementStrategy *strategy);
+const BM_ReplacementPolicy *getReplacementPolicy (ReplacementStrategy strategy);
+int getFrameFixCount (BM_BufferPool *const bm, int frameIndex);
+
 // Buffer Manager Interface Pool Handling
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData);
+RC initBufferPoolMode(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, SM_FileMode mode);
+RC initBufferPoolMemory(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, SM_FileMode mode, BM_FrameMemory memory);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -54,11 +138,35 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
 
+// Durability
+RC setFlushPolicy (BM_BufferPool *const bm, SM_SyncPolicy policy, int windowMicros, int windowSize);
+RC getFlushSyncStats (BM_BufferPool *const bm, SM_SyncStats *stats);
+
+// Background Writer
+RC startBackgroundWriter (BM_BufferPool *const bm, int cleanTarget, int intervalMicros);
+RC stopBackgroundWriter (BM_BufferPool *const bm);
+RC getWriterStats (BM_BufferPool *const bm, BM_WriterStats *stats);
+
+// Shared Page Tables
+RC initSharedPageTable (BM_SharedPageTable *const table);
+RC shutdownSharedPageTable (BM_SharedPageTable *const table);
+RC attachBufferPool (BM_BufferPool *const bm, BM_SharedPageTable *const table);
+
+// Read-Ahead
+RC setReadAhead (BM_BufferPool *const bm, int maxWindow);
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber startPage, int count);
+RC getReadAheadStats (BM_BufferPool *const bm, BM_ReadAheadStats *stats);
+
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
 bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getNumFlushRuns (BM_BufferPool *const bm);
+int getNumHits (BM_BufferPool *const bm);
+int getNumMisses (BM_BufferPool *const bm);
+int getPoolPageSize (BM_BufferPool *const bm);
+BM_FrameMemory getFrameMemory (BM_BufferPool *const bm);
 
 #endif
@@ -98,8 +98,13 @@ printStrat (BM_BufferPool *const bm)
 	case RS_LRU_K:
 		printf("LRU-K");
 		break;
+	case RS_2Q:
+		printf("2Q");
+		break;
 	default:
-		printf("%i", bm->strategy);
+		if (getReplacementPolicy(bm->strategy) != NULL)
+			printf("%s", getReplacementPolicy(bm->strategy)->name);
+		else printf("%i", bm->strategy);
 		break;
 	}
 }
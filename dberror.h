@@ -4,6 +4,7 @@
 #include "stdio.h"
 
 /* module wide constants */
+// the default (and smallest) page size, a page file can use larger pages (see `createPageFileSize`)
 #define PAGE_SIZE 4096
 
 /* return code definitions */
@@ -14,6 +15,8 @@ typedef int RC;
 #define RC_FILE_HANDLE_NOT_INIT 2
 #define RC_WRITE_FAILED 3
 #define RC_READ_NON_EXISTING_PAGE 4
+#define RC_FILE_MODE_NOT_SUPPORTED 5
+#define RC_PAGE_SIZE_NOT_SUPPORTED 6
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
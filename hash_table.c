@@ -1,123 +1,169 @@
 #include "hash_table.h"
 #include <stdlib.h>
+#include <limits.h>
 
-#define ARRAY_LIST_SIZE 16
+// marks a free slot, so INT_MIN can't be used as a key
+#define HT_EMPTY INT_MIN
+
+// the table doubles once more than 3/4 of its slots are used
+#define HT_MAX_LOAD_NUM 3
+#define HT_MAX_LOAD_DEN 4
 
 typedef struct HT_KeyValuePair {
     int key;
     int value;
 } HT_KeyValuePair;
 
-typedef struct HT_ArrayList {
+// an open-addressing table with linear probing, `capacity` is a power of two
+typedef struct HT_Table {
     int capacity;
-    int size;
-    HT_KeyValuePair *list;
-} HT_ArrayList;
+    int count;
+    HT_KeyValuePair *slots;
+} HT_Table;
 
-HT_ArrayList *AL_get(HT_TableHandle *const ht, int i)
+// scramble the key so neighbouring keys (page numbers) don't end up in one run of slots
+unsigned int HT_hash(int key)
 {
-    HT_ArrayList *ls = (HT_ArrayList *)ht->mgmt;
-    return &ls[i];
+    unsigned int h = (unsigned int)key;
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
 }
 
-int AL_push(HT_ArrayList *al, int key, int value)
+HT_KeyValuePair *HT_allocSlots(int capacity)
 {
-    if (al->size == al->capacity)
-    {
-        al->capacity += ARRAY_LIST_SIZE;
-        al->list = realloc(al->list, sizeof(HT_KeyValuePair) * al->capacity);
-        if (al->list == NULL)
-            return 1;
-    }
-    al->list[al->size].key = key;
-    al->list[al->size].value = value;
-    al->size++;
-    return 0;
+    HT_KeyValuePair *slots = malloc(sizeof(HT_KeyValuePair) * capacity);
+    if (slots == NULL)
+        return NULL;
+    for (int i = 0; i < capacity; i++)
+        slots[i].key = HT_EMPTY;
+    return slots;
 }
 
-void AL_remoteAt(HT_ArrayList *al, int i)
+// return the slot holding the key, or the free slot that ends its probe sequence
+int HT_find(HT_Table *table, int key)
 {
-    if (i >= 0 && i < al->size) {
-        for (int j = i; j < al->size - 1; j++)
-            al->list[j] = al->list[j + 1];
-        al->size--;
-    }
+    int mask = table->capacity - 1;
+    int i = HT_hash(key) & mask;
+    while (table->slots[i].key != HT_EMPTY && table->slots[i].key != key)
+        i = (i + 1) & mask;
+    return i;
 }
 
-// initialize hash table
-int initHashTable(HT_TableHandle *const ht, int size) 
+int HT_grow(HT_Table *table)
 {
-    ht->size = size;
-    ht->mgmt = malloc(sizeof(HT_ArrayList) * size);
-    for (int i = 0; i < size; i++)
+    HT_KeyValuePair *old = table->slots;
+    int oldCapacity = table->capacity;
+    HT_KeyValuePair *slots = HT_allocSlots(oldCapacity * 2);
+    if (slots == NULL)
+        return 1;
+    table->slots = slots;
+    table->capacity = oldCapacity * 2;
+    for (int i = 0; i < oldCapacity; i++)
     {
-        HT_ArrayList *al = AL_get(ht, i);
-        al->list = malloc(sizeof(HT_KeyValuePair) * ARRAY_LIST_SIZE);
-        if (al->list == NULL)
-            return 1;
-        al->capacity = ARRAY_LIST_SIZE;
-        al->size = 0;
+        if (old[i].key != HT_EMPTY)
+            table->slots[HT_find(table, old[i].key)] = old[i];
     }
+    free(old);
+    return 0;
+}
+
+// initialize hash table (`size` is the number of keys expected, the table grows past it as needed)
+int initHashTable(HT_TableHandle *const ht, int size)
+{
+    HT_Table *table = malloc(sizeof(HT_Table));
+    ht->mgmt = table;
+    ht->size = 0;
+    if (table == NULL)
+        return 1;
+
+    // the smallest power of two that holds `size` keys without going over the load factor
+    table->capacity = 8;
+    while (table->capacity < INT_MAX / 2 && (long)size * HT_MAX_LOAD_DEN > (long)table->capacity * HT_MAX_LOAD_NUM)
+        table->capacity *= 2;
+    table->count = 0;
+    table->slots = HT_allocSlots(table->capacity);
+    if (table->slots == NULL)
+        return 1;
     return 0;
 }
 
 // if the key is found then assign to value and return 0
 // else return 1
-int getValue(HT_TableHandle *const ht, int key, int *value) 
+int getValue(HT_TableHandle *const ht, int key, int *value)
 {
-    int i = key % ht->size;
-    HT_ArrayList *al  = AL_get(ht, i);
-    for (int j = 0; j < al->size; j++)
-    {
-        if (al->list[j].key == key)
-        {
-            *value = al->list[j].value;
-            return 0;
-        }
-    }
-    return 1;
+    HT_Table *table = (HT_Table *)ht->mgmt;
+    if (key == HT_EMPTY)
+        return 1;
+    int i = HT_find(table, key);
+    if (table->slots[i].key == HT_EMPTY)
+        return 1;
+    *value = table->slots[i].value;
+    return 0;
 }
 
 // if the key exists, then assign value to it
 // else, add in a new HT_KeyValuePair
-int setValue(HT_TableHandle *const ht, int key, int value) 
+int setValue(HT_TableHandle *const ht, int key, int value)
 {
-    int i = key % ht->size;
-    HT_ArrayList *al  = AL_get(ht, i);
-    for (int j = 0; j < al->size; j++)
+    HT_Table *table = (HT_Table *)ht->mgmt;
+    if (key == HT_EMPTY)
+        return 1;
+    int i = HT_find(table, key);
+    if (table->slots[i].key == HT_EMPTY)
     {
-        if (al->list[j].key == key)
+        // grow before the table gets too full to probe quickly
+        if ((long)(table->count + 1) * HT_MAX_LOAD_DEN > (long)table->capacity * HT_MAX_LOAD_NUM)
         {
-            al->list[j].value = value;
-            return 0;
+            if (HT_grow(table) != 0)
+                return 1;
+            i = HT_find(table, key);
         }
+        table->slots[i].key = key;
+        table->count++;
+        ht->size = table->count;
     }
-    return AL_push(al, key, value);
+    table->slots[i].value = value;
+    return 0;
 }
 
-// remove a HT_KeyValuePair 
-int removePair(HT_TableHandle *const ht, int key) 
+// remove a HT_KeyValuePair
+int removePair(HT_TableHandle *const ht, int key)
 {
-    int i = key % ht->size;
-    HT_ArrayList *al  = AL_get(ht, i);
-    for (int j = 0; j < al->size; j++)
+    HT_Table *table = (HT_Table *)ht->mgmt;
+    if (key == HT_EMPTY)
+        return 1;
+    int mask = table->capacity - 1;
+    int i = HT_find(table, key);
+    if (table->slots[i].key == HT_EMPTY)
+        return 1;
+
+    // shift the rest of the run back into the hole instead of leaving a tombstone,
+    // a pair only moves if the hole is between its home slot and where it is now
+    for (int j = (i + 1) & mask; table->slots[j].key != HT_EMPTY; j = (j + 1) & mask)
     {
-        if (al->list[j].key == key)
+        int home = HT_hash(table->slots[j].key) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask))
         {
-            AL_remoteAt(al, j);
-            return 0;
+            table->slots[i] = table->slots[j];
+            i = j;
         }
     }
-    return 1;
+    table->slots[i].key = HT_EMPTY;
+    table->count--;
+    ht->size = table->count;
+    return 0;
 }
 
 // free malloc's
 void freeHashTable(HT_TableHandle *const ht)
 {
-    for (int i = 0; i < ht->size; i++)
-    {
-        HT_ArrayList *al = AL_get(ht, i);
-        free(al->list);
-    }
-    free(ht->mgmt);
-}
\ No newline at end of file
+    HT_Table *table = (HT_Table *)ht->mgmt;
+    if (table != NULL)
+        free(table->slots);
+    free(table);
+    ht->mgmt = NULL;
+}
@@ -1,4 +1,5 @@
 typedef struct HT_TableHandle {
+    // the number of pairs in the table
     int size;
     void *mgmt;
 } HT_TableHandle;
@@ -0,0 +1,230 @@
+#include "priority_queue.h"
+#include <stdlib.h>
+
+typedef struct PQ_Entry {
+    long priority;
+    // when the item was queued or last re-prioritized, breaks ties so equal priorities come out in order
+    long order;
+    int item;
+} PQ_Entry;
+
+typedef struct PQ_Heap {
+    int capacity;
+    // the binary heap itself
+    PQ_Entry *entries;
+    // where each item sits in `entries` (-1 if it isn't queued)
+    int *positions;
+    long nextOrder;
+} PQ_Heap;
+
+PQ_Heap *PQ_get(PQ_QueueHandle *const pq)
+{
+    return (PQ_Heap *)pq->mgmt;
+}
+
+// true if `a` comes out of the queue before `b`
+int PQ_before(PQ_Entry *a, PQ_Entry *b)
+{
+    return a->priority < b->priority || (a->priority == b->priority && a->order < b->order);
+}
+
+void PQ_place(PQ_Heap *heap, int i, PQ_Entry entry)
+{
+    heap->entries[i] = entry;
+    heap->positions[entry.item] = i;
+}
+
+// move the entry at `i` up until its parent is not larger
+void PQ_siftUp(PQ_Heap *heap, int i)
+{
+    PQ_Entry entry = heap->entries[i];
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (!PQ_before(&entry, &(heap->entries[parent])))
+            break;
+        PQ_place(heap, i, heap->entries[parent]);
+        i = parent;
+    }
+    PQ_place(heap, i, entry);
+}
+
+// move the entry at `i` down until neither child is smaller
+void PQ_siftDown(PQ_Heap *heap, int size, int i)
+{
+    PQ_Entry entry = heap->entries[i];
+    while (2 * i + 1 < size)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < size && PQ_before(&(heap->entries[child + 1]), &(heap->entries[child])))
+            child++;
+        if (!PQ_before(&(heap->entries[child]), &entry))
+            break;
+        PQ_place(heap, i, heap->entries[child]);
+        i = child;
+    }
+    PQ_place(heap, i, entry);
+}
+
+// make room for items up to `item`
+int PQ_grow(PQ_Heap *heap, int item)
+{
+    int capacity = heap->capacity;
+    while (capacity <= item)
+        capacity *= 2;
+    PQ_Entry *entries = realloc(heap->entries, sizeof(PQ_Entry) * capacity);
+    if (entries == NULL)
+        return 1;
+    heap->entries = entries;
+    int *positions = realloc(heap->positions, sizeof(int) * capacity);
+    if (positions == NULL)
+        return 1;
+    heap->positions = positions;
+    for (int i = heap->capacity; i < capacity; i++)
+        heap->positions[i] = -1;
+    heap->capacity = capacity;
+    return 0;
+}
+
+// initialize an empty queue for the items `0` to `capacity - 1` (it grows if larger items are set)
+int initPriorityQueue(PQ_QueueHandle *const pq, int capacity)
+{
+    if (capacity < 1)
+        capacity = 1;
+    PQ_Heap *heap = malloc(sizeof(PQ_Heap));
+    if (heap == NULL)
+        return 1;
+    heap->capacity = capacity;
+    heap->nextOrder = 0;
+    heap->entries = malloc(sizeof(PQ_Entry) * capacity);
+    heap->positions = malloc(sizeof(int) * capacity);
+    pq->size = 0;
+    pq->mgmt = heap;
+    if (heap->entries == NULL || heap->positions == NULL)
+        return 1;
+    for (int i = 0; i < capacity; i++)
+        heap->positions[i] = -1;
+    return 0;
+}
+
+// queue the item with a priority or change the priority of a queued item
+// either way it comes after the items already queued with the same priority
+int setPriority(PQ_QueueHandle *const pq, int item, long priority)
+{
+    PQ_Heap *heap = PQ_get(pq);
+    if (item < 0 || (item >= heap->capacity && PQ_grow(heap, item) != 0))
+        return 1;
+    int i = heap->positions[item];
+    if (i < 0)
+    {
+        // append and move it up
+        i = pq->size++;
+        PQ_Entry entry = { priority, heap->nextOrder++, item };
+        PQ_place(heap, i, entry);
+        PQ_siftUp(heap, i);
+    }
+    else
+    {
+        // move it whichever way the new priority needs
+        PQ_Entry old = heap->entries[i];
+        heap->entries[i].priority = priority;
+        heap->entries[i].order = heap->nextOrder++;
+        if (PQ_before(&(heap->entries[i]), &old))
+            PQ_siftUp(heap, i);
+        else PQ_siftDown(heap, pq->size, i);
+    }
+    return 0;
+}
+
+// if the item is queued then remove it and return 0
+// else return 1
+int removeItem(PQ_QueueHandle *const pq, int item)
+{
+    PQ_Heap *heap = PQ_get(pq);
+    if (item < 0 || item >= heap->capacity || heap->positions[item] < 0)
+        return 1;
+    int i = heap->positions[item];
+    heap->positions[item] = -1;
+
+    // fill the hole with the last entry and restore the heap order from there
+    pq->size--;
+    if (i < pq->size)
+    {
+        PQ_Entry last = heap->entries[pq->size];
+        PQ_Entry old = heap->entries[i];
+        PQ_place(heap, i, last);
+        if (PQ_before(&last, &old))
+            PQ_siftUp(heap, i);
+        else PQ_siftDown(heap, pq->size, i);
+    }
+    return 0;
+}
+
+// if the queue is not empty then assign the item with the smallest priority to item and return 0
+// else return 1
+int peekMin(PQ_QueueHandle *const pq, int *item)
+{
+    if (pq->size == 0)
+        return 1;
+    *item = PQ_get(pq)->entries[0].item;
+    return 0;
+}
+
+// assign the (up to `max`) items with the smallest priorities to `items`, in the order they would come out,
+// without removing them, and return how many were assigned
+int peekSmallest(PQ_QueueHandle *const pq, int *items, int max)
+{
+    PQ_Heap *heap = PQ_get(pq);
+    if (max <= 0 || pq->size == 0)
+        return 0;
+
+    // the next item is always the smallest of the heap positions whose parents were taken
+    // (each one taken adds at most two, so there are never more than `max + 1`)
+    int *candidates = malloc(sizeof(int) * (max + 1));
+    if (candidates == NULL)
+        return 0;
+    int numCandidates = 1;
+    int count = 0;
+    candidates[0] = 0;
+    while (count < max && numCandidates > 0)
+    {
+        int best = 0;
+        for (int i = 1; i < numCandidates; i++)
+        {
+            if (PQ_before(&(heap->entries[candidates[i]]), &(heap->entries[candidates[best]])))
+                best = i;
+        }
+        int position = candidates[best];
+        candidates[best] = candidates[--numCandidates];
+        items[count++] = heap->entries[position].item;
+        for (int child = 2 * position + 1; child <= 2 * position + 2; child++)
+        {
+            if (child < pq->size)
+                candidates[numCandidates++] = child;
+        }
+    }
+    free(candidates);
+    return count;
+}
+
+// divide every priority by 2^shift (rounding down), items keep their order among equal priorities
+void decayPriorities(PQ_QueueHandle *const pq, int shift)
+{
+    PQ_Heap *heap = PQ_get(pq);
+    for (int i = 0; i < pq->size; i++)
+        heap->entries[i].priority >>= shift;
+
+    // priorities that were different may now be equal, so rebuild the heap bottom up
+    for (int i = pq->size / 2 - 1; i >= 0; i--)
+        PQ_siftDown(heap, pq->size, i);
+}
+
+void freePriorityQueue(PQ_QueueHandle *const pq)
+{
+    PQ_Heap *heap = PQ_get(pq);
+    free(heap->entries);
+    free(heap->positions);
+    free(heap);
+    pq->mgmt = NULL;
+    pq->size = 0;
+}
@@ -0,0 +1,19 @@
+#ifndef PRIORITY_QUEUE_H
+#define PRIORITY_QUEUE_H
+
+// an indexed min-heap of the items `0` to `capacity - 1`, each with a `long` priority
+// (ties go to the item queued or re-prioritized first)
+typedef struct PQ_QueueHandle {
+    int size;
+    void *mgmt;
+} PQ_QueueHandle;
+
+int initPriorityQueue(PQ_QueueHandle *const pq, int capacity);
+int setPriority(PQ_QueueHandle *const pq, int item, long priority);
+int removeItem(PQ_QueueHandle *const pq, int item);
+int peekMin(PQ_QueueHandle *const pq, int *item);
+int peekSmallest(PQ_QueueHandle *const pq, int *items, int max);
+void decayPriorities(PQ_QueueHandle *const pq, int shift);
+void freePriorityQueue(PQ_QueueHandle *const pq);
+
+#endif
@@ -8,25 +8,30 @@
 /* Macros */
 
 #define PAGE_FILE_NAME "DATA.bin"
+#define DEFAULT_NUM_PAGES 16
+#define DEFAULT_READ_AHEAD 8
 #define TABLE_NAME_SIZE 16
 #define ATTR_NAME_SIZE 16
 #define MAX_NUM_ATTR 8
 #define MAX_NUM_KEYS 4
 #define MAX_NUM_TABLES PAGE_SIZE / (sizeof(RM_SystemSchema) + sizeof(int) * 2)
+#define MAX_NUM_POOLS 8
+#define POOL_NAME_SIZE 16
 
 #define USE_PAGE_HANDLE_HEADER(errorValue) \
 int const error = errorValue; \
 RC result; \
 BM_PageHandle handle; \
-RM_PageHeader *header; 
+RM_PageHeader *header; \
+BM_BufferPool *pool = &bufferPool;
 
 #define BEGIN_USE_PAGE_HANDLE_HEADER(pageNum) \
-result = pinPage(&bufferPool, &handle, pageNum); \
+result = pinPage(pool, &handle, pageNum); \
 if (result != RC_OK) return error; \
 header = getPageHeader(&handle);
 
 #define END_USE_PAGE_HANDLE_HEADER() \
-result = unpinPage(&bufferPool, &handle); \
+result = unpinPage(pool, &handle); \
 if (result != RC_OK) return error;
 
 /* Additional Definitions */
@@ -62,24 +67,43 @@ typedef struct RM_ScanData {
     Expr *cond;
 } RM_ScanData;
 
+// a pool tables can be opened in besides the catalog's (see addBufferPool)
+typedef struct RM_NamedPool {
+    char name[POOL_NAME_SIZE];
+    BM_BufferPool pool;
+} RM_NamedPool;
+
+// what an open table keeps outside the catalog: its main page (pinned) and the pool its pages are pinned through
+typedef struct RM_OpenTable {
+    BM_PageHandle handle;
+    BM_BufferPool *pool;
+} RM_OpenTable;
+
 /* Global variables */
 
 BM_BufferPool bufferPool;
 BM_PageHandle catalogPageHandle;
 
+// the named pools share one page table with `bufferPool`, so no page is cached twice
+BM_SharedPageTable sharedPageTable;
+RM_NamedPool namedPools[MAX_NUM_POOLS];
+int numNamedPools = 0;
+
 /* Declarations */
 
 RM_SystemCatalog* getSystemCatalog();
 RC markSystemCatalogDirty();
 RM_SystemSchema *getTableByName(char *name);
 RM_PageHeader *getPageHeader(BM_PageHandle* handle);
+BM_BufferPool *getTablePool(RM_SystemSchema *table);
+RC initPool(BM_BufferPool *pool, char *fileName, RM_Options *options);
 bool *getSlots(BM_PageHandle* handle);
 char *getTupleData(BM_PageHandle* handle);
 int getFreePage();
 int initNewPage(RM_SystemSchema *table, Schema *schema, int pageNum);
 int appendToFreeList(int pageNum);
 int getAttrSize(Schema *schema, int attrIndex);
-int insertRecordOnPage(BM_PageHandle *handle, Schema *schema, Record *record);
+int insertRecordOnPage(BM_BufferPool *pool, BM_PageHandle *handle, Schema *schema, Record *record);
 int scanForMatchOnPage(BM_PageHandle *handle, RM_TableData *rel, RID startId, Record *record, Expr *cond);
 
 /* Helpers */
@@ -113,6 +137,13 @@ RM_SystemSchema *getTableByName(char *name)
     return NULL;
 }
 
+// helper to get the pool an open table's pages are pinned through (the catalog's if it isn't open)
+BM_BufferPool *getTablePool(RM_SystemSchema *table)
+{
+    if (table->handle == NULL) return &bufferPool;
+    return ((RM_OpenTable *)table->handle)->pool;
+}
+
 // helper to get get page header from a page frame 
 RM_PageHeader *getPageHeader(BM_PageHandle* handle)
 {
@@ -171,7 +202,7 @@ int getFreePage()
         BEGIN_USE_PAGE_HANDLE_HEADER(newPage);
         {
             header->nextPage = header->prevPage = NO_PAGE;
-            markDirty(&bufferPool, &handle);
+            markDirty(pool, &handle);
         }
         END_USE_PAGE_HANDLE_HEADER();
         return newPage;
@@ -186,7 +217,7 @@ int getFreePage()
             nextPage = header->nextPage;
             header->nextPage = header->prevPage = NO_PAGE;
             catalog->freePage = nextPage;
-            markDirty(&bufferPool, &handle);
+            markDirty(pool, &handle);
             markSystemCatalogDirty();
         }
         END_USE_PAGE_HANDLE_HEADER();
@@ -197,7 +228,7 @@ int getFreePage()
         BEGIN_USE_PAGE_HANDLE_HEADER(nextPage);
         {
             header->prevPage = 0;
-            markDirty(&bufferPool, &handle);
+            markDirty(pool, &handle);
         }
         END_USE_PAGE_HANDLE_HEADER();
         return newPage;
@@ -207,16 +238,17 @@ int getFreePage()
 // helper initialize a new page
 RC initNewPage(RM_SystemSchema *table, Schema *schema, int pageNum)
 {
-    int pageHeader = sizeof(pageHeader);
+    int pageHeader = sizeof(RM_PageHeader);
     int slotSize = sizeof(bool);
     int recordSize = getRecordSize(schema);
-    int recordsPerPage = (PAGE_SIZE - pageHeader) / (recordSize + slotSize);
+    int recordsPerPage = (getPoolPageSize(&bufferPool) - pageHeader) / (recordSize + slotSize);
     if (recordsPerPage <= 0) return RC_WRITE_FAILED;
 
     // check if main page or if table is open
     if (pageNum != table->pageNum || table->handle == NULL)
     {
         USE_PAGE_HANDLE_HEADER(RC_WRITE_FAILED);
+        pool = getTablePool(table);
         BEGIN_USE_PAGE_HANDLE_HEADER(pageNum);
         {
             // mark all the slots as free
@@ -226,7 +258,7 @@ RC initNewPage(RM_SystemSchema *table, Schema *schema, int pageNum)
             {
                 slots[slotIndex] = FALSE;
             }
-            result = markDirty(&bufferPool, &handle);
+            result = markDirty(pool, &handle);
             if (result != RC_OK)  return result;
         }
         END_USE_PAGE_HANDLE_HEADER();
@@ -242,7 +274,7 @@ RC initNewPage(RM_SystemSchema *table, Schema *schema, int pageNum)
         {
             slots[slotIndex] = FALSE;
         }
-        RC result = markDirty(&bufferPool, table->handle);
+        RC result = markDirty(getTablePool(table), table->handle);
         if (result != RC_OK)  return result;
         return RC_OK;
     }
@@ -263,7 +295,7 @@ int appendToFreeList(int pageNum)
         {
             header->prevPage = 0;
             catalog->freePage = pageNum;
-            markDirty(&bufferPool, &handle);
+            markDirty(pool, &handle);
             markSystemCatalogDirty();
         }
         END_USE_PAGE_HANDLE_HEADER();
@@ -282,7 +314,7 @@ int appendToFreeList(int pageNum)
                 if (header->nextPage == NO_PAGE)
                 {
                     header->nextPage = catalog->freePage;
-                    markDirty(&bufferPool, &handle);
+                    markDirty(pool, &handle);
                     END_USE_PAGE_HANDLE_HEADER();
                     break;
                 }
@@ -295,7 +327,7 @@ int appendToFreeList(int pageNum)
         BEGIN_USE_PAGE_HANDLE_HEADER(catalog->freePage);
         {
             header->prevPage = curPage;
-            markDirty(&bufferPool, &handle);
+            markDirty(pool, &handle);
         }
         END_USE_PAGE_HANDLE_HEADER();
 
@@ -304,7 +336,7 @@ int appendToFreeList(int pageNum)
         {
             header->prevPage = 0;
             catalog->freePage = pageNum;
-            markDirty(&bufferPool, &handle);
+            markDirty(pool, &handle);
             markSystemCatalogDirty();
         }
         END_USE_PAGE_HANDLE_HEADER();
@@ -322,6 +354,7 @@ int getNextPage(RM_SystemSchema *table, int pageNum)
 
     int nextPage;
     USE_PAGE_HANDLE_HEADER(NO_PAGE);
+    pool = getTablePool(table);
     BEGIN_USE_PAGE_HANDLE_HEADER(pageNum);
     {
         nextPage = header->nextPage;
@@ -332,35 +365,66 @@ int getNextPage(RM_SystemSchema *table, int pageNum)
 
 /* Table and Manager */
 
+void initRecordManagerOptions(RM_Options *options)
+{
+    options->fileName = NULL;
+    options->pageSize = PAGE_SIZE;
+    options->numPages = DEFAULT_NUM_PAGES;
+    options->strategy = RS_2Q;
+    options->stratData = NULL;
+    options->mode = SM_MODE_DEFAULT;
+    options->memory = BM_MEMORY_DEFAULT;
+    options->readAhead = DEFAULT_READ_AHEAD;
+    options->syncPolicy = SM_SYNC_NONE;
+    options->syncWindowMicros = 0;
+    options->syncWindowSize = 0;
+}
+
 RC initRecordManager(void *mgmtData)
 {
-    // ensure the system catalog can fit into one page
+    RM_Options options;
+    initRecordManagerOptions(&options);
+
+    // mgmtData parameter holds the page file name to use
+    options.fileName = (char *)mgmtData;
+    return initRecordManagerWithOptions(&options);
+}
+
+RC initRecordManagerWithOptions(RM_Options *options)
+{
+    // ensure the system catalog can fit into one page (no page file uses pages smaller than `PAGE_SIZE`)
     if (PAGE_SIZE < sizeof(RM_SystemCatalog) || MAX_NUM_TABLES <= 0) return RC_IM_NO_MORE_ENTRIES;
 
     RC result;
     char *fileName;
     bool newSystem = 0;
 
-    // mgmtData parameter holds the page file name to use (use default name if NULL)
-    if (mgmtData == NULL) fileName = PAGE_FILE_NAME;
-    else fileName = (char *)mgmtData;
+    // use default name if no file name is given
+    if (options->fileName == NULL) fileName = PAGE_FILE_NAME;
+    else fileName = options->fileName;
 
-    // check if the file needs to be created
+    // check if the file needs to be created (with a header only if its pages aren't `PAGE_SIZE`,
+    // so default files stay readable by older builds)
     if (access(fileName, F_OK) != 0)
     {
-        result = createPageFile(fileName);
+        if (options->pageSize == PAGE_SIZE) result = createPageFile(fileName);
+        else result = createPageFileSize(fileName, options->pageSize);
         if (result != RC_OK) return result;
         newSystem = 1;
     }  
 
-    result = initBufferPool(&bufferPool, fileName, 16, RS_LRU, NULL);
+    result = initPool(&bufferPool, fileName, options);
     if (result != RC_OK) return result;
-
     result = pinPage(&bufferPool, &catalogPageHandle, 0);
-    if (result != RC_OK) return result;
+    if (result != RC_OK)
+    {
+        shutdownBufferPool(&bufferPool);
+        return result;
+    }
+    numNamedPools = 0;
 
-    // create system schema if it's a new file
-    if (newSystem)
+    // create system schema if it's a new file (or a page file that was created empty ahead of time)
+    if (newSystem || getSystemCatalog()->totalNumPages == 0)
     {
         RM_SystemCatalog *catalog = getSystemCatalog();
         catalog->totalNumPages = 1;
@@ -374,12 +438,78 @@ RC initRecordManager(void *mgmtData)
     return RC_OK;
 }
 
+// helper to set up a pool of the record manager from the options (the pool is shut down again on failure)
+RC initPool(BM_BufferPool *pool, char *fileName, RM_Options *options)
+{
+    RC result = initBufferPoolMemory(pool, fileName, options->numPages, options->strategy, 
+        options->stratData, options->mode, options->memory);
+    if (result != RC_OK) return result;
+
+    // tables are read page after page by scans, so let the pool read ahead of them
+    // (mapped pages are faulted in by the OS, which reads ahead on its own)
+    if (options->mode != SM_MODE_MMAP) result = setReadAhead(pool, options->readAhead);
+    if (result == RC_OK && options->syncPolicy != SM_SYNC_NONE) 
+        result = setFlushPolicy(pool, options->syncPolicy, options->syncWindowMicros, options->syncWindowSize);
+    if (result != RC_OK) shutdownBufferPool(pool);
+    return result;
+}
+
+RC addBufferPool(char *poolName, RM_Options *options)
+{
+    // check the name is free and there is room for another pool
+    if (strlen(poolName) >= POOL_NAME_SIZE) return RC_WRITE_FAILED;
+    for (int poolIndex = 0; poolIndex < numNamedPools; poolIndex++)
+    {
+        if (strcmp(namedPools[poolIndex].name, poolName) == 0) return RC_WRITE_FAILED;
+    }
+    if (numNamedPools >= MAX_NUM_POOLS) return RC_IM_NO_MORE_ENTRIES;
+
+    // the pool is over the record manager's page file, whatever file the options name
+    RM_NamedPool *namedPool = &(namedPools[numNamedPools]);
+    RC result = initPool(&(namedPool->pool), ((SM_FileHandle *)bufferPool.pageFile)->fileName, options);
+    if (result != RC_OK) return result;
+
+    // the catalog's pool joins the shared page table with the first named pool
+    if (sharedPageTable.mgmtData == NULL)
+    {
+        result = initSharedPageTable(&sharedPageTable);
+        if (result == RC_OK) result = attachBufferPool(&bufferPool, &sharedPageTable);
+        if (result != RC_OK)
+        {
+            shutdownSharedPageTable(&sharedPageTable);
+            shutdownBufferPool(&(namedPool->pool));
+            return result;
+        }
+    }
+    result = attachBufferPool(&(namedPool->pool), &sharedPageTable);
+    if (result != RC_OK)
+    {
+        shutdownBufferPool(&(namedPool->pool));
+        return result;
+    }
+    strcpy(namedPool->name, poolName);
+    numNamedPools++;
+    return RC_OK;
+}
+
 RC shutdownRecordManager()
 {
-    RC result = unpinPage(&bufferPool, &catalogPageHandle);
+    RC result;
+
+    // the named pools go first (their pages are written back and read from the file from then on)
+    while (numNamedPools > 0)
+    {
+        result = shutdownBufferPool(&(namedPools[numNamedPools - 1].pool));
+        if (result != RC_OK) return result;
+        numNamedPools--;
+    }
+    result = unpinPage(&bufferPool, &catalogPageHandle);
     if (result != RC_OK) return result;
     result = shutdownBufferPool(&bufferPool);
     if (result != RC_OK) return result;
+
+    // the catalog's pool was the last one on the shared page table
+    if (sharedPageTable.mgmtData != NULL) return shutdownSharedPageTable(&sharedPageTable);
     return RC_OK;
 }
 
@@ -426,10 +556,24 @@ RC createTable(char *name, Schema *schema)
 }
 
 RC openTable(RM_TableData *rel, char *name)
+{
+    return openTableInPool(rel, name, NULL);
+}
+
+RC openTableInPool(RM_TableData *rel, char *name, char *poolName)
 {
     RM_SystemSchema *table = getTableByName(name);
     if (table == NULL) return RC_IM_KEY_NOT_FOUND;
     if (table->handle != NULL) return RC_WRITE_FAILED;
+
+    // find the pool (the catalog's if none is named)
+    BM_BufferPool *pool = NULL;
+    if (poolName == NULL) pool = &bufferPool;
+    for (int poolIndex = 0; pool == NULL && poolIndex < numNamedPools; poolIndex++)
+    {
+        if (strcmp(namedPools[poolIndex].name, poolName) == 0) pool = &(namedPools[poolIndex].pool);
+    }
+    if (pool == NULL) return RC_IM_KEY_NOT_FOUND;
     rel->name = table->name;
     rel->schema = (Schema *)malloc(sizeof(Schema));
     rel->schema->attrNames = (char **)malloc(sizeof(char*) * table->numAttr);
@@ -450,10 +594,12 @@ RC openTable(RM_TableData *rel, char *name)
     // the RM_TableData will also point to the system schema
     // the system schema stays open until the RM is shut down 
     rel->mgmtData = (void *)table;
-    table->handle = (BM_PageHandle *)malloc(sizeof(BM_PageHandle));
+    RM_OpenTable *openData = (RM_OpenTable *)malloc(sizeof(RM_OpenTable));
+    openData->pool = pool;
+    table->handle = &(openData->handle);
 
     // pin the table's page
-    RC result = pinPage(&bufferPool, table->handle, table->pageNum);
+    RC result = pinPage(pool, table->handle, table->pageNum);
     return result;
 }
 
@@ -462,13 +608,13 @@ RC closeTable(RM_TableData *rel)
     RM_SystemSchema *table = getSystemSchema(rel);
 
     // unpin and force the page to disk
-    RC result = unpinPage(&bufferPool, table->handle);
+    RC result = unpinPage(getTablePool(table), table->handle);
     if (result != RC_OK) return result;
-    result = forcePage(&bufferPool, table->handle);
+    result = forcePage(getTablePool(table), table->handle);
     if (result != RC_OK && result != RC_IM_KEY_NOT_FOUND) return result;
     free((void *)rel->schema->attrNames);
     free((void *)rel->schema);
-    free(table->handle);
+    free((RM_OpenTable *)table->handle);
     table->handle = NULL;
     return RC_OK;
 }
@@ -552,7 +698,7 @@ int getNumTables()
 /* Handling records in a table */
 
 // returns slotIndex for success and -1 for failure
-int insertRecordOnPage(BM_PageHandle *handle, Schema *schema, Record *record)
+int insertRecordOnPage(BM_BufferPool *pool, BM_PageHandle *handle, Schema *schema, Record *record)
 {
     RM_PageHeader *header = getPageHeader(handle);
     bool *slots = getSlots(handle);
@@ -564,7 +710,7 @@ int insertRecordOnPage(BM_PageHandle *handle, Schema *schema, Record *record)
             char *tupleData = getTupleDataAt(handle, recordSize, slotIndex);
             memcpy(tupleData, record->data, recordSize);
             slots[slotIndex] = true;
-            RC result = markDirty(&bufferPool, handle);
+            RC result = markDirty(pool, handle);
             if (result != RC_OK) return 1;
             record->id.page = handle->pageNum;
             record->id.slot = slotIndex;
@@ -582,7 +728,7 @@ RC insertRecord (RM_TableData *rel, Record *record)
     bool *slots = getSlots(table->handle);
 
     // check the main page for space
-    slotIndex = insertRecordOnPage(table->handle, rel->schema, record);
+    slotIndex = insertRecordOnPage(getTablePool(table), table->handle, rel->schema, record);
     if (slotIndex >= 0)
     {
         table->numTuples++;
@@ -598,9 +744,10 @@ RC insertRecord (RM_TableData *rel, Record *record)
     while (pageNum != NO_PAGE)
     {
         USE_PAGE_HANDLE_HEADER(RC_WRITE_FAILED);
+        pool = getTablePool(table);
         BEGIN_USE_PAGE_HANDLE_HEADER(pageNum);
         {
-            slotIndex = insertRecordOnPage(&handle, rel->schema, record);
+            slotIndex = insertRecordOnPage(pool, &handle, rel->schema, record);
             if (slotIndex >= 0)
             {
                 END_USE_PAGE_HANDLE_HEADER();
@@ -626,14 +773,15 @@ RC insertRecord (RM_TableData *rel, Record *record)
     if (result == RC_OK)
     {
         USE_PAGE_HANDLE_HEADER(RC_WRITE_FAILED);
+        pool = getTablePool(table);
         BEGIN_USE_PAGE_HANDLE_HEADER(newPage);
         {
-            slotIndex = insertRecordOnPage(&handle, rel->schema, record);
+            slotIndex = insertRecordOnPage(pool, &handle, rel->schema, record);
             if (slotIndex >= 0)
             {
                 // update new page's prev
                 header->prevPage = prevPage;
-                result = markDirty(&bufferPool, &handle);
+                result = markDirty(pool, &handle);
                 if (result != RC_OK) return result;
                 END_USE_PAGE_HANDLE_HEADER();
 
@@ -647,7 +795,7 @@ RC insertRecord (RM_TableData *rel, Record *record)
                     BEGIN_USE_PAGE_HANDLE_HEADER(prevPage);
                     {
                         header->nextPage = newPage;
-                        result = markDirty(&bufferPool, &handle);
+                        result = markDirty(pool, &handle);
                         if (result != RC_OK) return result;
                     }
                     END_USE_PAGE_HANDLE_HEADER();
@@ -669,6 +817,7 @@ RC insertRecord (RM_TableData *rel, Record *record)
 #define BEGIN_USE_TABLE_PAGE_HANDLE_HEADER(id) \
 RM_SystemSchema *table = getSystemSchema(rel); \
 USE_PAGE_HANDLE_HEADER(RC_WRITE_FAILED); \
+pool = getTablePool(table); \
 if (id.page == table->pageNum) \
 { \
     handle = *table->handle; \
@@ -695,7 +844,7 @@ RC deleteRecord (RM_TableData *rel, RID id)
         slots[id.slot] = FALSE;
         table->numTuples--;
         markSystemCatalogDirty();
-        result = markDirty(&bufferPool, &handle);
+        result = markDirty(pool, &handle);
         if (result != RC_OK) return RC_WRITE_FAILED;
     }
     END_USE_TABLE_PAGE_HANDLE_HEADER();
@@ -713,7 +862,7 @@ RC updateRecord (RM_TableData *rel, Record *record)
         int recordSize = getRecordSize(rel->schema);
         char *tupleData = getTupleDataAt(&handle, recordSize, id.slot);
         memcpy(tupleData, record->data, recordSize);
-        result = markDirty(&bufferPool, &handle);
+        result = markDirty(pool, &handle);
         if (result != RC_OK) return RC_WRITE_FAILED;
     }
     END_USE_TABLE_PAGE_HANDLE_HEADER();
@@ -749,6 +898,10 @@ RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
     scanData->id.slot = -1;
     scanData->id.page = handle->pageNum;
     scanData->cond = cond;
+
+    // start reading the first overflow page while the main page is scanned
+    if (getPageHeader(handle)->nextPage != NO_PAGE)
+        prefetchPages(getTablePool(table), getPageHeader(handle)->nextPage, 1);
     return RC_OK;
 }
 
@@ -808,16 +961,28 @@ RC next (RM_ScanHandle *scan, Record *record)
     while (scanData->id.page != NO_PAGE)
     {
         USE_PAGE_HANDLE_HEADER(RC_WRITE_FAILED);
+        pool = getTablePool(table);
         BEGIN_USE_PAGE_HANDLE_HEADER(scanData->id.page);
         {
+            // the chain isn't always in page order, so ask for the next page when a page is entered
+            if (scanData->id.slot == 0 && header->nextPage != NO_PAGE)
+                prefetchPages(pool, header->nextPage, 1);
             scanResult = scanForMatchOnPage(&handle, rel, scanData->id, record, scanData->cond);
-            if (scanResult == 0) return RC_OK;
+            if (scanResult == 0) 
+            {
+                END_USE_PAGE_HANDLE_HEADER();
+                return RC_OK;
+            }
             else if (scanResult == -1)
             {
                 scanData->id.page = header->nextPage;
                 scanData->id.slot = 0;
             }
-            else return RC_WRITE_FAILED;
+            else 
+            {
+                END_USE_PAGE_HANDLE_HEADER();
+                return RC_WRITE_FAILED;
+            }
         }
         END_USE_PAGE_HANDLE_HEADER();
     }
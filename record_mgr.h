@@ -5,6 +5,9 @@
 #include "expr.h"
 #include "tables.h"
 
+// Include the replacement strategies, page file modes and sync policies
+#include "buffer_mgr.h"
+
 // Bookkeeping for scans
 typedef struct RM_ScanHandle
 {
@@ -12,11 +15,31 @@ typedef struct RM_ScanHandle
 	void *mgmtData;
 } RM_ScanHandle;
 
+// How the record manager sets up its buffer pool (fill with initRecordManagerOptions first)
+typedef struct RM_Options
+{
+	char *fileName;			// page file (NULL for the default)
+	int pageSize;			// page size of a page file that is created (see createPageFileSize)
+	int numPages;			// frames in the buffer pool
+	ReplacementStrategy strategy;
+	void *stratData;		// the strategy's parameters (see initBufferPool)
+	SM_FileMode mode;
+	BM_FrameMemory memory;		// what backs the pool's frames (see initBufferPoolMemory)
+	int readAhead;			// most pages read ahead of a scan (0 turns read-ahead off)
+	SM_SyncPolicy syncPolicy;	// when written pages are synced (see setFlushPolicy)
+	int syncWindowMicros;
+	int syncWindowSize;
+} RM_Options;
+
 // table and manager
+extern void initRecordManagerOptions (RM_Options *options);
 extern RC initRecordManager (void *mgmtData);
+extern RC initRecordManagerWithOptions (RM_Options *options);
 extern RC shutdownRecordManager ();
+extern RC addBufferPool (char *poolName, RM_Options *options);
 extern RC createTable (char *name, Schema *schema);
 extern RC openTable (RM_TableData *rel, char *name);
+extern RC openTableInPool (RM_TableData *rel, char *name, char *poolName);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
 extern int getNumTuples (RM_TableData *rel);
@@ -1,83 +1,827 @@
+#define _GNU_SOURCE
 #include "storage_mgr.h"
+#include "dt.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/* Additional Definitions */
+
+// the most pages moved by a single vectored call
+#ifdef IOV_MAX
+#define MAX_IOV IOV_MAX
+#else
+#define MAX_IOV 1024
+#endif
+
+// the address space reserved for a mapped page file, the mapping grows inside of it
+// so that addresses handed out by `mapBlock` never move
+#define MAP_RESERVE_SIZE (1L << 36)
+
+// identifies a segmented page file's manifest
+#define SEGMENT_MAGIC "SMSEGMNT"
+
+// identifies a page file that starts with a header, files without one are legacy `PAGE_SIZE` files
+#define HEADER_MAGIC "SMPGFILE"
+
+// the header takes up this many bytes at the start of the file so the pages after it stay aligned
+#define HEADER_SIZE SM_IO_ALIGNMENT
+
+typedef struct SM_FileHeader {
+    char magic[8];
+    int pageSize;
+} SM_FileHeader;
+
+// stored at `fileName` for segmented page files, the pages themselves live in the segment files
+typedef struct SM_SegmentManifest {
+    char magic[8];
+    int pagesPerSegment;
+    int numDirs;
+    char dirs[SM_MAX_SEGMENT_DIRS][SM_MAX_PATH];
+    int pageSize;
+} SM_SegmentManifest;
+
+// bookkeeping for the sync policy, requests are numbered so that one fsync can cover 
+// every request made before it started
+typedef struct SM_SyncState {
+    pthread_mutex_t lock;
+    // signaled when an fsync completes
+    pthread_cond_t done;
+    // wakes the group commit thread
+    pthread_cond_t wake;
+    SM_SyncPolicy policy;
+    int windowMicros;
+    int windowSize;
+    // the last request made and the last request made durable (and the result of the fsync that did)
+    long requested;
+    long durable;
+    RC durableResult;
+    bool syncing;
+    // requests waiting for the group commit window and when the first of them was made
+    int pending;
+    long firstPendingMicros;
+    pthread_t thread;
+    bool threadRunning;
+    bool stopThread;
+    SM_SyncStats stats;
+} SM_SyncState;
+
+typedef struct SM_FileMgmt {
+    // one raw file descriptor per segment (a plain page file is a single unbounded segment)
+    // all I/O is positional so no shared file offset is ever moved
+    // the array never moves and a segment is only counted once its descriptor is in it, so 
+    // readers take no lock while the file grows
+    int *fds;
+    atomic_int numSegments;
+    int maxSegments;
+    // growing the file (and its mapping) is done by one thread at a time
+    pthread_mutex_t growLock;
+    int pagesPerSegment;
+    // the layout of a segmented page file (NULL for a plain page file)
+    SM_SegmentManifest *manifest;
+    char *fileName;
+    int flags;
+    SM_FileMode mode;
+    // the size of every page and where the first one starts in the (first) file
+    int pageSize;
+    off_t dataOffset;
+    // start of the reserved address range and the number of pages currently mapped (SM_MODE_MMAP)
+    char *map;
+    int mappedPages;
+    // `ensureCapacity` grows the file to at least `totalNumPages * growthFactor` pages
+    float growthFactor;
+    SM_SyncState sync;
+} SM_FileMgmt;
+
+/* Helpers */
+
+bool _isAligned(const void *ptr)
+{
+    return ((uintptr_t)ptr % SM_IO_ALIGNMENT) == 0;
+}
+
+// allocate a page of memory aligned for direct I/O and fill it with `\0` bytes
+void *_allocEmptyPage(int pageSize)
+{
+    void *page;
+    if (posix_memalign(&page, SM_IO_ALIGNMENT, pageSize) != 0) return NULL;
+    memset(page, '\0', pageSize);
+    return page;
+}
+
+// page sizes are powers of two from `PAGE_SIZE` up to `SM_MAX_PAGE_SIZE`
+bool _isValidPageSize(int pageSize)
+{
+    return pageSize >= PAGE_SIZE && pageSize <= SM_MAX_PAGE_SIZE && (pageSize & (pageSize - 1)) == 0;
+}
+
+// keep calling `pread` until `size` bytes are read, returns the number of bytes read
+ssize_t _preadFull(int fd, char *buf, size_t size, off_t offset)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t n = pread(fd, buf + total, size - total, offset + total);
+        if (n <= 0) break;
+        total += n;
+    }
+    return total;
+}
+
+// keep calling `pwrite` until `size` bytes are written, returns the number of bytes written
+ssize_t _pwriteFull(int fd, const char *buf, size_t size, off_t offset)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t n = pwrite(fd, buf + total, size - total, offset + total);
+        if (n <= 0) break;
+        total += n;
+    }
+    return total;
+}
+
+// size in bytes of the file behind `fd`, -1 if it can't be read
+off_t _getFileSize(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    return st.st_size;
+}
+
+// size in bytes of `numPages` pages, computed in 64 bits so files can grow past 2 GiB
+off_t _pageOffset(SM_FileMgmt *mgmt, long numPages)
+{
+    return (off_t)numPages * mgmt->pageSize;
+}
+
+// find the segment holding `pageNum`, set its descriptor and the page's offset inside of it
+// returns the number of pages from `pageNum` to the end of the segment
+int _locatePage(SM_FileMgmt *mgmt, int pageNum, int *fd, off_t *offset)
+{
+    int segment = pageNum / mgmt->pagesPerSegment;
+    int segmentPage = pageNum % mgmt->pagesPerSegment;
+    *fd = mgmt->fds[segment];
+    *offset = mgmt->dataOffset + _pageOffset(mgmt, segmentPage);
+    return mgmt->pagesPerSegment - segmentPage;
+}
+
+// write the path of segment `segment` of a segmented page file into `path`
+// segments are striped round robin over the manifest's directories
+// returns RC_WRITE_FAILED if the path doesn't fit in `SM_MAX_PATH` bytes
+RC _segmentPath(SM_SegmentManifest *manifest, char *fileName, int segment, char *path)
+{
+    int length;
+    if (manifest->numDirs == 0)
+    {
+        length = snprintf(path, SM_MAX_PATH, "%s.%d", fileName, segment);
+    }
+    else
+    {
+        char *baseName = strrchr(fileName, '/');
+        baseName = (baseName == NULL) ? fileName : baseName + 1;
+        length = snprintf(path, SM_MAX_PATH, "%s/%s.%d", manifest->dirs[segment % manifest->numDirs], baseName, segment);
+    }
+    if (length < 0 || length >= SM_MAX_PATH) return RC_WRITE_FAILED;
+    else return RC_OK;
+}
+
+// make sure the path of every segment a segmented page file can have fits in `SM_MAX_PATH` bytes
+// (the last segments have the longest numbers, and one of them goes to each directory)
+RC _checkSegmentPaths(SM_SegmentManifest *manifest, char *fileName)
+{
+    char path[SM_MAX_PATH];
+    int numDirs = (manifest->numDirs > 0) ? manifest->numDirs : 1;
+    for (int i = 0; i < numDirs; i++)
+    {
+        if (_segmentPath(manifest, fileName, SM_MAX_SEGMENTS - 1 - i, path) != RC_OK)
+            return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+// read the manifest at `fileName`, returns 1 if it is a segmented page file and 0 otherwise
+int _readManifest(char *fileName, SM_SegmentManifest *manifest)
+{
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return 0;
+    ssize_t bytesRead = _preadFull(fd, (char *)manifest, sizeof(SM_SegmentManifest), 0);
+    close(fd);
+    if (bytesRead != sizeof(SM_SegmentManifest)) return 0;
+    return memcmp(manifest->magic, SEGMENT_MAGIC, sizeof(manifest->magic)) == 0;
+}
+
+// open (and create if needed) the next segment of a segmented page file
+RC _openNextSegment(SM_FileMgmt *mgmt, bool create)
+{
+    char path[SM_MAX_PATH];
+    if (_segmentPath(mgmt->manifest, mgmt->fileName, mgmt->numSegments, path) != RC_OK) return RC_FILE_NOT_FOUND;
+    int fd = open(path, create ? mgmt->flags | O_CREAT : mgmt->flags, 0644);
+    if (fd < 0) return RC_FILE_NOT_FOUND;
+    if (mgmt->numSegments >= mgmt->maxSegments)
+    {
+        close(fd);
+        return RC_WRITE_FAILED;
+    }
+    mgmt->fds[mgmt->numSegments] = fd;
+    atomic_store(&(mgmt->numSegments), mgmt->numSegments + 1);
+    return RC_OK;
+}
+
+// read one page, bouncing it through an aligned page if direct I/O can't use `memPage`
+RC _readPage(SM_FileMgmt *mgmt, int pageNum, SM_PageHandle memPage)
+{
+    char *buf = memPage;
+    if (mgmt->mode == SM_MODE_DIRECT && !_isAligned(memPage)) 
+    {
+        buf = _allocEmptyPage(mgmt->pageSize);
+        if (buf == NULL) return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    // read at the page's offset without touching any shared file position
+    int fd;
+    off_t offset;
+    _locatePage(mgmt, pageNum, &fd, &offset);
+    ssize_t bytesRead = _preadFull(fd, buf, mgmt->pageSize, offset);
+    if (buf != memPage)
+    {
+        memcpy(memPage, buf, mgmt->pageSize);
+        free(buf);
+    }
+
+    // make sure the page was entirely read
+    if (bytesRead != mgmt->pageSize) return RC_READ_NON_EXISTING_PAGE;
+    else return RC_OK;
+}
+
+// write one page, bouncing it through an aligned page if direct I/O can't use `memPage`
+RC _writePage(SM_FileMgmt *mgmt, int pageNum, SM_PageHandle memPage)
+{
+    char *buf = memPage;
+    if (mgmt->mode == SM_MODE_DIRECT && !_isAligned(memPage)) 
+    {
+        buf = _allocEmptyPage(mgmt->pageSize);
+        if (buf == NULL) return RC_WRITE_FAILED;
+        memcpy(buf, memPage, mgmt->pageSize);
+    }
+
+    // write at the page's offset without touching any shared file position
+    int fd;
+    off_t offset;
+    _locatePage(mgmt, pageNum, &fd, &offset);
+    ssize_t bytesWritten = _pwriteFull(fd, buf, mgmt->pageSize, offset);
+    if (buf != memPage) free(buf);
+    if (bytesWritten != mgmt->pageSize) return RC_WRITE_FAILED;
+    else return RC_OK;
+}
+
+// advance an iovec array past `n` consumed bytes, returns the number of iovecs left
+int _advanceIov(struct iovec **iov, int iovcnt, size_t n)
+{
+    while (iovcnt > 0 && n >= (*iov)->iov_len)
+    {
+        n -= (*iov)->iov_len;
+        (*iov)++;
+        iovcnt--;
+    }
+    if (iovcnt > 0)
+    {
+        (*iov)->iov_base = (char *)(*iov)->iov_base + n;
+        (*iov)->iov_len -= n;
+    }
+    return iovcnt;
+}
+
+// keep calling `preadv` until every iovec is filled, returns the number of bytes read
+// NOTE the iovec array is consumed
+ssize_t _preadvFull(int fd, struct iovec *iov, int iovcnt, off_t offset)
+{
+    size_t total = 0;
+    while (iovcnt > 0)
+    {
+        ssize_t n = preadv(fd, iov, iovcnt, offset + total);
+        if (n <= 0) break;
+        total += n;
+        iovcnt = _advanceIov(&iov, iovcnt, n);
+    }
+    return total;
+}
+
+// keep calling `pwritev` until every iovec is written, returns the number of bytes written
+// NOTE the iovec array is consumed
+ssize_t _pwritevFull(int fd, struct iovec *iov, int iovcnt, off_t offset)
+{
+    size_t total = 0;
+    while (iovcnt > 0)
+    {
+        ssize_t n = pwritev(fd, iov, iovcnt, offset + total);
+        if (n <= 0) break;
+        total += n;
+        iovcnt = _advanceIov(&iov, iovcnt, n);
+    }
+    return total;
+}
+
+// move `count` pages starting at `startPage` between the file and `buffers` with as few 
+// vectored calls as possible (one per `MAX_IOV` pages and segment)
+RC _transferBlocks(int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *buffers, bool write)
+{
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+    struct iovec iov[MAX_IOV];
+    int done = 0;
+
+    // direct I/O needs every buffer aligned, otherwise move the pages one at a time
+    for (int i = 0; i < count && mgmt->mode == SM_MODE_DIRECT; i++)
+    {
+        if (!_isAligned(buffers[i]))
+        {
+            for (int j = 0; j < count; j++)
+            {
+                RC result;
+                if (write) result = _writePage(mgmt, startPage + j, buffers[j]);
+                else result = _readPage(mgmt, startPage + j, buffers[j]);
+                if (result != RC_OK) return result;
+            }
+            return RC_OK;
+        }
+    }
+
+    while (done < count)
+    {
+        // gather the next batch of page buffers (a batch never crosses a segment)
+        int fd;
+        off_t offset;
+        int batch = _locatePage(mgmt, startPage + done, &fd, &offset);
+        if (batch > count - done) batch = count - done;
+        if (batch > MAX_IOV) batch = MAX_IOV;
+        for (int i = 0; i < batch; i++)
+        {
+            iov[i].iov_base = buffers[done + i];
+            iov[i].iov_len = mgmt->pageSize;
+        }
+
+        ssize_t expected = _pageOffset(mgmt, batch);
+        if (write)
+        {
+            if (_pwritevFull(fd, iov, batch, offset) != expected) return RC_WRITE_FAILED;
+        }
+        else
+        {
+            if (_preadvFull(fd, iov, batch, offset) != expected) return RC_READ_NON_EXISTING_PAGE;
+        }
+        done += batch;
+    }
+    return RC_OK;
+}
+
+// map the pages the file grew by since the last call into the reserved range
+RC _extendMapping(SM_FileMgmt *mgmt, int totalNumPages)
+{
+    if (mgmt->mode != SM_MODE_MMAP || totalNumPages <= mgmt->mappedPages) return RC_OK;
+    if (_pageOffset(mgmt, totalNumPages) > MAP_RESERVE_SIZE) return RC_WRITE_FAILED;
+    off_t offset = _pageOffset(mgmt, mgmt->mappedPages);
+    off_t length = _pageOffset(mgmt, totalNumPages - mgmt->mappedPages);
+
+    // map over the reserved (inaccessible) range so pages already handed out stay put
+    // the file's header is left out, so the mapping starts with page 0
+    void *addr = mmap(mgmt->map + offset, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, 
+            mgmt->fds[0], mgmt->dataOffset + offset);
+    if (addr == MAP_FAILED) return RC_WRITE_FAILED;
+    mgmt->mappedPages = totalNumPages;
+    return RC_OK;
+}
+
+// grow the file to `numPages` pages of `\0` bytes with a single preallocation per segment
+RC _growFile(SM_FileMgmt *mgmt, int numPages)
+{
+    // only the last open segment and new segments can grow, the ones before it are full
+    int numSegments = (numPages - 1) / mgmt->pagesPerSegment + 1;
+    for (int segment = mgmt->numSegments - 1; segment < numSegments; segment++)
+    {
+        if (segment >= mgmt->numSegments && _openNextSegment(mgmt, true) != RC_OK) 
+            return RC_WRITE_FAILED;
+        long segmentPages = numPages - (long)segment * mgmt->pagesPerSegment;
+        if (segmentPages > mgmt->pagesPerSegment) segmentPages = mgmt->pagesPerSegment;
+        off_t size = mgmt->dataOffset + _pageOffset(mgmt, segmentPages);
+
+        // never shrink a segment (another handle on the file may have grown it further)
+        off_t currentSize = _getFileSize(mgmt->fds[segment]);
+        if (currentSize < 0) return RC_WRITE_FAILED;
+        if (currentSize >= size) continue;
+
+        // reserve the blocks up front where the file system supports it, otherwise extend the size (sparse)
+        if (fallocate(mgmt->fds[segment], 0, 0, size) != 0 && ftruncate(mgmt->fds[segment], size) != 0) 
+            return RC_WRITE_FAILED;
+    }
+    return _extendMapping(mgmt, numPages);
+}
+
+long _nowMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+// fsync every segment (and the mapping in SM_MODE_MMAP)
+RC _syncAll(SM_FileMgmt *mgmt)
+{
+    RC result = RC_OK;
+    if (mgmt->map != NULL && mgmt->mappedPages > 0 && msync(mgmt->map, _pageOffset(mgmt, mgmt->mappedPages), MS_SYNC) != 0)
+        result = RC_WRITE_FAILED;
+    for (int i = 0; i < mgmt->numSegments; i++)
+    {
+        if (fdatasync(mgmt->fds[i]) != 0) result = RC_WRITE_FAILED;
+    }
+    return result;
+}
+
+// make every request up to `request` durable, sharing fsyncs with other threads
+// returns the result of the fsync that covered the request
+// NOTE must be called with the sync lock held
+RC _syncUpTo(SM_FileMgmt *mgmt, long request)
+{
+    SM_SyncState *sync = &(mgmt->sync);
+    while (sync->durable < request)
+    {
+        if (sync->syncing)
+        {
+            // an fsync is already running, wait for it and check if it covered the request
+            pthread_cond_wait(&(sync->done), &(sync->lock));
+            continue;
+        }
+
+        // become the leader, the fsync covers every request made so far
+        long covered = sync->requested;
+        sync->syncing = true;
+        sync->pending = 0;
+        pthread_mutex_unlock(&(sync->lock));
+        long start = _nowMicros();
+        RC result = _syncAll(mgmt);
+        long elapsed = _nowMicros() - start;
+        pthread_mutex_lock(&(sync->lock));
+
+        sync->stats.numSyncs++;
+        sync->stats.totalSyncMicros += elapsed;
+        if (elapsed > sync->stats.maxSyncMicros) sync->stats.maxSyncMicros = elapsed;
+        sync->durable = covered;
+        sync->durableResult = result;
+        sync->syncing = false;
+        pthread_cond_broadcast(&(sync->done));
+    }
+    return sync->durableResult;
+}
+
+// the group commit thread makes pending requests durable once the time window runs out
+void *_groupCommitThread(void *arg)
+{
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)arg;
+    SM_SyncState *sync = &(mgmt->sync);
+    pthread_mutex_lock(&(sync->lock));
+    while (!sync->stopThread)
+    {
+        if (sync->pending == 0)
+        {
+            pthread_cond_wait(&(sync->wake), &(sync->lock));
+            continue;
+        }
+
+        // sleep until the window of the oldest pending request closes
+        long deadline = sync->firstPendingMicros + sync->windowMicros;
+        if (_nowMicros() < deadline)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            long wait = deadline - _nowMicros();
+            ts.tv_sec += wait / 1000000;
+            ts.tv_nsec += (wait % 1000000) * 1000;
+            if (ts.tv_nsec >= 1000000000) 
+            {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&(sync->wake), &(sync->lock), &ts);
+            continue;
+        }
+        _syncUpTo(mgmt, sync->requested);
+    }
+    pthread_mutex_unlock(&(sync->lock));
+    return NULL;
+}
+
+// stop the group commit thread if it is running
+void _stopGroupCommit(SM_FileMgmt *mgmt)
+{
+    SM_SyncState *sync = &(mgmt->sync);
+    pthread_mutex_lock(&(sync->lock));
+    bool running = sync->threadRunning;
+    sync->stopThread = true;
+    sync->threadRunning = false;
+    pthread_cond_broadcast(&(sync->wake));
+    pthread_mutex_unlock(&(sync->lock));
+    if (running) pthread_join(sync->thread, NULL);
+}
+
+void _initSyncState(SM_SyncState *sync)
+{
+    pthread_mutex_init(&(sync->lock), NULL);
+    pthread_cond_init(&(sync->done), NULL);
+    pthread_cond_init(&(sync->wake), NULL);
+    sync->policy = SM_SYNC_NONE;
+    sync->windowMicros = 0;
+    sync->windowSize = 0;
+    sync->requested = 0;
+    sync->durable = 0;
+    sync->durableResult = RC_OK;
+    sync->syncing = false;
+    sync->pending = 0;
+    sync->firstPendingMicros = 0;
+    sync->threadRunning = false;
+    sync->stopThread = false;
+    memset(&(sync->stats), 0, sizeof(SM_SyncStats));
+}
+
+// the page count is only raised once the new pages (and their segments) exist, so the range 
+// checks of reads and writes can load it without taking the grow lock
+int _getNumPages(SM_FileHandle *fHandle)
+{
+    return __atomic_load_n(&(fHandle->totalNumPages), __ATOMIC_ACQUIRE);
+}
+
+void _setNumPages(SM_FileHandle *fHandle, int numPages)
+{
+    __atomic_store_n(&(fHandle->totalNumPages), numPages, __ATOMIC_RELEASE);
+}
 
 /* manipulating page files */
 
 void initStorageManager(void) { }
 
-RC createPageFile(char *fileName)
+// create a file holding a single page of `\0` bytes, preceded by a header if `header` is set
+RC _createFile(char *fileName, int pageSize, bool header)
 {
-    FILE *fp = fopen(fileName, "w+");
-    if (fp == NULL) return RC_FILE_NOT_FOUND;
+    int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return RC_FILE_NOT_FOUND;
     else
     {
         // allocate a page of memory and fill the page with `\0` bytes
-        void *emptyPage = malloc(PAGE_SIZE); 
-        memset(emptyPage, '\0', PAGE_SIZE);
+        char *emptyPage = (char *)_allocEmptyPage(header ? HEADER_SIZE + pageSize : pageSize);
+        if (emptyPage == NULL)
+        {
+            close(fd);
+            return RC_WRITE_FAILED;
+        }
+
+        // the header records the page size in front of the first page
+        ssize_t size = pageSize;
+        if (header)
+        {
+            SM_FileHeader *fileHeader = (SM_FileHeader *)emptyPage;
+            memcpy(fileHeader->magic, HEADER_MAGIC, sizeof(fileHeader->magic));
+            fileHeader->pageSize = pageSize;
+            size += HEADER_SIZE;
+        }
 
         // write the page to disk and close the file
-        size_t bytesWritten = fwrite(emptyPage, sizeof(char), PAGE_SIZE, fp);
-        fclose(fp);
+        ssize_t bytesWritten = _pwriteFull(fd, emptyPage, size, 0);
+        close(fd);
         free(emptyPage);
 
         // make sure the page was entirely written
-        if (bytesWritten != PAGE_SIZE) return RC_WRITE_FAILED;
+        if (bytesWritten != size) return RC_WRITE_FAILED;
         else return RC_OK;
     }
 }
 
-long _getFileSize(FILE *file)
+// read the header of a plain page file, returns 1 if it has one and 0 for a legacy file
+int _readHeader(int fd, SM_FileHeader *fileHeader)
 {
-    // move the file pointer to the end
-    fseek(file, 0L, SEEK_END); 
+    // direct I/O needs an aligned buffer
+    char *buf = (char *)_allocEmptyPage(HEADER_SIZE);
+    if (buf == NULL) return 0;
+    ssize_t bytesRead = _preadFull(fd, buf, HEADER_SIZE, 0);
+    memcpy(fileHeader, buf, sizeof(SM_FileHeader));
+    free(buf);
+    return bytesRead == HEADER_SIZE && memcmp(fileHeader->magic, HEADER_MAGIC, sizeof(fileHeader->magic)) == 0;
+}
 
-    // find the position of the file pointer from the start of the file
-    long size = ftell(file); 
+RC createPageFile(char *fileName)
+{
+    // no header, so the file stays readable by older builds
+    return _createFile(fileName, PAGE_SIZE, false);
+}
 
-     // move the file pointer back to the beginning
-    rewind(file);
-    return size;
+RC createPageFileSize(char *fileName, int pageSize)
+{
+    if (!_isValidPageSize(pageSize)) return RC_PAGE_SIZE_NOT_SUPPORTED;
+    return _createFile(fileName, pageSize, true);
+}
+
+RC createSegmentedPageFile(char *fileName, int pageSize, int pagesPerSegment, int numDirs, char **dirs)
+{
+    if (!_isValidPageSize(pageSize)) return RC_PAGE_SIZE_NOT_SUPPORTED;
+    if (pagesPerSegment <= 0 || numDirs < 0 || numDirs > SM_MAX_SEGMENT_DIRS) return RC_WRITE_FAILED;
+
+    // describe the layout in the manifest
+    SM_SegmentManifest manifest;
+    memset(&manifest, '\0', sizeof(SM_SegmentManifest));
+    memcpy(manifest.magic, SEGMENT_MAGIC, sizeof(manifest.magic));
+    manifest.pagesPerSegment = pagesPerSegment;
+    manifest.numDirs = numDirs;
+    manifest.pageSize = pageSize;
+    for (int i = 0; i < numDirs; i++)
+    {
+        if (strlen(dirs[i]) >= SM_MAX_PATH) return RC_WRITE_FAILED;
+        strcpy(manifest.dirs[i], dirs[i]);
+    }
+    if (_checkSegmentPaths(&manifest, fileName) != RC_OK) return RC_WRITE_FAILED;
+
+    int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return RC_FILE_NOT_FOUND;
+    ssize_t bytesWritten = _pwriteFull(fd, (char *)&manifest, sizeof(SM_SegmentManifest), 0);
+    close(fd);
+    if (bytesWritten != sizeof(SM_SegmentManifest)) return RC_WRITE_FAILED;
+
+    // the first segment holds a single page of `\0` bytes, the page size is kept in the manifest
+    char path[SM_MAX_PATH];
+    if (_segmentPath(&manifest, fileName, 0, path) != RC_OK) return RC_WRITE_FAILED;
+    return _createFile(path, pageSize, false);
 }
 
 RC openPageFile(char *fileName, SM_FileHandle *fHandle)
 {
-    FILE *fp = fopen(fileName, "r+");
+    return openPageFileMode(fileName, fHandle, SM_MODE_DEFAULT);
+}
+
+RC openPageFileMode(char *fileName, SM_FileHandle *fHandle, SM_FileMode mode)
+{
+    SM_SegmentManifest manifest;
+    bool segmented = _readManifest(fileName, &manifest);
+
+    // a mapping needs the pages to be in one file
+    if (segmented && mode == SM_MODE_MMAP) return RC_FILE_MODE_NOT_SUPPORTED;
+    if (segmented && !_isValidPageSize(manifest.pageSize)) return RC_PAGE_SIZE_NOT_SUPPORTED;
+
+    // (a segment whose path is cut short could be another file's)
+    if (segmented && _checkSegmentPaths(&manifest, fileName) != RC_OK) return RC_FILE_NOT_FOUND;
+
+    // direct I/O bypasses the OS page cache
+    int flags = O_RDWR;
+    if (mode == SM_MODE_DIRECT) flags |= O_DIRECT;
+    int fd = segmented ? -1 : open(fileName, flags);
 
-    if (fp == NULL) return RC_FILE_NOT_FOUND;
+    // the file system may refuse direct I/O even though the file exists
+    if (fd < 0 && !segmented && mode == SM_MODE_DIRECT && errno == EINVAL) return RC_FILE_MODE_NOT_SUPPORTED;
+    if (fd < 0 && !segmented) return RC_FILE_NOT_FOUND;
     else
     {
-        // get the size of the file and divide by page size to get `totalNumPages`
-        int size = _getFileSize(fp);
-        int totalNumPages = size / PAGE_SIZE;
+        // store the file descriptors in `mgmtInfo` to use else where
+        SM_FileMgmt *mgmt = (SM_FileMgmt *)malloc(sizeof(SM_FileMgmt));
+        mgmt->fileName = fileName;
+        mgmt->flags = flags;
+        mgmt->fds = NULL;
+        atomic_init(&(mgmt->numSegments), 0);
+        mgmt->manifest = NULL;
+        mgmt->pageSize = PAGE_SIZE;
+        mgmt->dataOffset = 0;
+        long totalNumPages;
+        if (segmented)
+        {
+            // open every segment there is, all but the last one are full
+            mgmt->manifest = (SM_SegmentManifest *)malloc(sizeof(SM_SegmentManifest));
+            *(mgmt->manifest) = manifest;
+            mgmt->pagesPerSegment = manifest.pagesPerSegment;
+            mgmt->pageSize = manifest.pageSize;
+            mgmt->fds = (int *)malloc(sizeof(int) * SM_MAX_SEGMENTS);
+            mgmt->maxSegments = SM_MAX_SEGMENTS;
+            while (_openNextSegment(mgmt, false) == RC_OK);
+            if (mgmt->numSegments == 0)
+            {
+                free(mgmt->fds);
+                free(mgmt->manifest);
+                free(mgmt);
+                return RC_FILE_NOT_FOUND;
+            }
+            totalNumPages = (long)(mgmt->numSegments - 1) * mgmt->pagesPerSegment;
+            totalNumPages += _getFileSize(mgmt->fds[mgmt->numSegments - 1]) / mgmt->pageSize;
+        }
+        else
+        {
+            // a plain page file is a single segment without a limit
+            mgmt->fds = (int *)malloc(sizeof(int));
+            mgmt->fds[0] = fd;
+            mgmt->maxSegments = 1;
+            atomic_init(&(mgmt->numSegments), 1);
+            mgmt->pagesPerSegment = INT_MAX;
+
+            // the pages come after the header, if there is one
+            SM_FileHeader fileHeader;
+            if (_readHeader(fd, &fileHeader))
+            {
+                mgmt->pageSize = fileHeader.pageSize;
+                mgmt->dataOffset = HEADER_SIZE;
+            }
+
+            // get the size of the file and divide by page size to get `totalNumPages`
+            totalNumPages = (_getFileSize(fd) - mgmt->dataOffset) / mgmt->pageSize;
+        }
+
+        // refuse a header (or manifest) that doesn't make sense instead of misreading every page
+        if (!_isValidPageSize(mgmt->pageSize))
+        {
+            for (int i = 0; i < mgmt->numSegments; i++)
+                close(mgmt->fds[i]);
+            free(mgmt->fds);
+            free(mgmt->manifest);
+            free(mgmt);
+            return RC_PAGE_SIZE_NOT_SUPPORTED;
+        }
+
+        // page numbers are `int`s, so that is as far as a file can be addressed
+        if (totalNumPages > INT_MAX) totalNumPages = INT_MAX;
         
         // set metadata
         fHandle->fileName = fileName;
         fHandle->totalNumPages = totalNumPages;
         fHandle->curPagePos = 0;
-
-        // store the file pointer in `mgmtInfo` to use else where
-        fHandle->mgmtInfo = (void *)fp;
+        fHandle->pageSize = mgmt->pageSize;
+        mgmt->mode = mode;
+        mgmt->map = NULL;
+        mgmt->mappedPages = 0;
+        mgmt->growthFactor = 1;
+        pthread_mutex_init(&(mgmt->growLock), NULL);
+        _initSyncState(&(mgmt->sync));
+        if (mode == SM_MODE_MMAP)
+        {
+            // reserve the address range up front and map the existing pages into it
+            void *map = mmap(NULL, MAP_RESERVE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (map != MAP_FAILED) mgmt->map = (char *)map;
+            if (mgmt->map == NULL || _extendMapping(mgmt, totalNumPages) != RC_OK)
+            {
+                if (mgmt->map != NULL) munmap(mgmt->map, MAP_RESERVE_SIZE);
+                free(mgmt->fds);
+                free(mgmt);
+                close(fd);
+                return RC_FILE_HANDLE_NOT_INIT;
+            }
+        }
+        fHandle->mgmtInfo = (void *)mgmt;
         return RC_OK;
     }
 }
 
 RC closePageFile (SM_FileHandle *fHandle)
 {
-    if (fclose((FILE *)fHandle->mgmtInfo) == 0)
-    {
-        // unset the file pointer
-        fHandle->mgmtInfo = NULL;
-        return RC_OK;
-    }
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+    if (mgmt == NULL) return RC_FILE_HANDLE_NOT_INIT;
+
+    // requests still waiting for their group commit window are made durable now
+    _stopGroupCommit(mgmt);
+    pthread_mutex_lock(&(mgmt->sync.lock));
+    if (mgmt->sync.policy != SM_SYNC_NONE) _syncUpTo(mgmt, mgmt->sync.requested);
+    pthread_mutex_unlock(&(mgmt->sync.lock));
+    pthread_mutex_destroy(&(mgmt->sync.lock));
+    pthread_cond_destroy(&(mgmt->sync.done));
+    pthread_cond_destroy(&(mgmt->sync.wake));
+    pthread_mutex_destroy(&(mgmt->growLock));
+    if (mgmt->map != NULL) munmap(mgmt->map, MAP_RESERVE_SIZE);
+    int closed = 0;
+    for (int i = 0; i < mgmt->numSegments; i++)
+        closed |= close(mgmt->fds[i]);
+
+    // unset the management info
+    free(mgmt->fds);
+    free(mgmt->manifest);
+    free(mgmt);
+    fHandle->mgmtInfo = NULL;
+    if (closed == 0) return RC_OK;
     else return RC_FILE_NOT_FOUND;
 }
 
 RC destroyPageFile (char *fileName)
 {
+    // remove the segments of a segmented page file before its manifest
+    SM_SegmentManifest manifest;
+    if (_readManifest(fileName, &manifest))
+    {
+        char path[SM_MAX_PATH];
+        for (int segment = 0; ; segment++)
+        {
+            if (_segmentPath(&manifest, fileName, segment, path) != RC_OK || remove(path) != 0) break;
+        }
+    }
     if (remove(fileName) == 0) return RC_OK;
 	else return RC_FILE_NOT_FOUND;
 }
@@ -87,20 +831,31 @@ RC destroyPageFile (char *fileName)
 RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     // check the handle to see if pageNum is in range
-    if (pageNum < 0 || pageNum >= fHandle->totalNumPages) 
+    if (pageNum < 0 || pageNum >= _getNumPages(fHandle)) 
         return RC_READ_NON_EXISTING_PAGE;
-    FILE *fp = (FILE *)fHandle->mgmtInfo;
+    return _readPage((SM_FileMgmt *)fHandle->mgmtInfo, pageNum, memPage);
+}
 
-    // check to see if the position was set successfully
-    if (fseek(fp, pageNum * PAGE_SIZE, SEEK_SET) == 0)
-    {
-        size_t bytesRead = fread(memPage, sizeof(char), PAGE_SIZE, fp);
+RC readBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *buffers)
+{
+    // check the handle to see if the whole run is in range
+    if (startPage < 0 || count < 0 || startPage + count > _getNumPages(fHandle)) 
+        return RC_READ_NON_EXISTING_PAGE;
+    return _transferBlocks(startPage, count, fHandle, buffers, false);
+}
 
-        // make sure the page was entirely read
-        if (bytesRead != PAGE_SIZE) return RC_READ_NON_EXISTING_PAGE;
-        else return RC_OK;
-    }    
-    else return RC_FILE_NOT_FOUND;
+RC mapBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle *memPage)
+{
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+    if (mgmt->mode != SM_MODE_MMAP) return RC_FILE_MODE_NOT_SUPPORTED;
+
+    // check the handle to see if pageNum is in range
+    if (pageNum < 0 || pageNum >= _getNumPages(fHandle)) 
+        return RC_READ_NON_EXISTING_PAGE;
+
+    // point straight into the mapping
+    *memPage = mgmt->map + _pageOffset(mgmt, pageNum);
+    return RC_OK;
 }
 
 int getBlockPos (SM_FileHandle *fHandle)
@@ -152,18 +907,31 @@ RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     // check the handle to see if pageNum is in range
-    if (pageNum < 0 || pageNum >= fHandle->totalNumPages) 
+    if (pageNum < 0 || pageNum >= _getNumPages(fHandle)) 
         return RC_READ_NON_EXISTING_PAGE;
-    FILE *fp = (FILE *)fHandle->mgmtInfo;
+    return _writePage((SM_FileMgmt *)fHandle->mgmtInfo, pageNum, memPage);
+}
 
-    // check to see if the position was set successfully
-    if (fseek(fp, pageNum * PAGE_SIZE, SEEK_SET) == 0)
-    {
-        size_t bytesWritten = fwrite(memPage, sizeof(char), PAGE_SIZE, fp);
-        if (bytesWritten != PAGE_SIZE) return RC_WRITE_FAILED;
-        else return RC_OK;
-    }    
-    else return RC_FILE_NOT_FOUND;
+RC writeBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *buffers)
+{
+    // check the handle to see if the whole run is in range
+    if (startPage < 0 || count < 0 || startPage + count > _getNumPages(fHandle)) 
+        return RC_READ_NON_EXISTING_PAGE;
+    return _transferBlocks(startPage, count, fHandle, buffers, true);
+}
+
+RC syncBlocks (int startPage, int count, SM_FileHandle *fHandle)
+{
+    // check the handle to see if the whole run is in range
+    if (startPage < 0 || count < 0 || startPage + count > _getNumPages(fHandle)) 
+        return RC_READ_NON_EXISTING_PAGE;
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+
+    // only the mapping holds unwritten changes, `writeBlock` already handed its data to the OS
+    if (mgmt->mode != SM_MODE_MMAP || count == 0) return RC_OK;
+    if (msync(mgmt->map + _pageOffset(mgmt, startPage), _pageOffset(mgmt, count), MS_SYNC) != 0) 
+        return RC_WRITE_FAILED;
+    else return RC_OK;
 }
 
 RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
@@ -174,39 +942,116 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 
 RC appendEmptyBlock (SM_FileHandle *fHandle)
 {
-    FILE *fp = (FILE *)fHandle->mgmtInfo;
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
 
-    // check to see if the position was set successfully
-    if (fseek(fp, 0, SEEK_END) == 0) 
-    {
-        // allocate a page of memory and fill the page with `\0` bytes
-        void *emptyPage = malloc(PAGE_SIZE); 
-        memset(emptyPage, '\0', PAGE_SIZE);
+    // extend the file by one page of `\0` bytes
+    pthread_mutex_lock(&(mgmt->growLock));
+    RC result = _growFile(mgmt, fHandle->totalNumPages + 1);
+    if (result == RC_OK) 
+        _setNumPages(fHandle, fHandle->totalNumPages + 1);
+    pthread_mutex_unlock(&(mgmt->growLock));
+    return result;
+}
 
-        // write the page to disk
-        size_t bytesWritten = fwrite(emptyPage, sizeof(char), PAGE_SIZE, fp);
-        free(emptyPage);
+RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
+{
+    if (_getNumPages(fHandle) >= numberOfPages) return RC_OK;
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+    pthread_mutex_lock(&(mgmt->growLock));
 
-        // make sure the page was entirely written
-        if (bytesWritten != PAGE_SIZE) 
-            return RC_WRITE_FAILED;
-        else
-        {
-            fHandle->totalNumPages++;
-            return RC_OK;
-        }
+    // grow by a whole extent (at least `growthFactor` times the current size) so that 
+    // files growing a page at a time don't cost a syscall per page
+    RC result = RC_OK;
+    int numPages = numberOfPages;
+    float extent = fHandle->totalNumPages * mgmt->growthFactor;
+    if (extent > numPages && extent < INT_MAX) numPages = (int)extent;
+    if (fHandle->totalNumPages < numberOfPages)
+    {
+        result = _growFile(mgmt, numPages);
+        if (result == RC_OK) 
+            _setNumPages(fHandle, numPages);
     }
-    else return RC_FILE_NOT_FOUND;
+    pthread_mutex_unlock(&(mgmt->growLock));
+    return result;
 }
 
-RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
+RC setGrowthFactor (float growthFactor, SM_FileHandle *fHandle)
 {
-    // while `totalNumPages` is less than `numberOfPages` keep calling `appendEmptyBlock`
-    while (fHandle->totalNumPages < numberOfPages)
+    // anything below 1 would shrink the extent below what was asked for
+    if (growthFactor < 1) return RC_WRITE_FAILED;
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+    mgmt->growthFactor = growthFactor;
+    return RC_OK;
+}
+
+/* durability */
+
+RC setSyncPolicy (SM_SyncPolicy policy, int windowMicros, int windowSize, SM_FileHandle *fHandle)
+{
+    if (policy == SM_SYNC_GROUP && (windowMicros <= 0 || windowSize <= 0)) return RC_WRITE_FAILED;
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+    SM_SyncState *sync = &(mgmt->sync);
+
+    // settle the requests made under the old policy before switching
+    _stopGroupCommit(mgmt);
+    pthread_mutex_lock(&(sync->lock));
+    RC result = RC_OK;
+    if (sync->policy != SM_SYNC_NONE) result = _syncUpTo(mgmt, sync->requested);
+    sync->policy = policy;
+    sync->windowMicros = windowMicros;
+    sync->windowSize = windowSize;
+    sync->stopThread = false;
+
+    // the group commit thread closes windows that no further request fills up
+    if (policy == SM_SYNC_GROUP)
+        sync->threadRunning = pthread_create(&(sync->thread), NULL, _groupCommitThread, mgmt) == 0;
+    pthread_mutex_unlock(&(sync->lock));
+    return result;
+}
+
+RC syncPageFile (SM_FileHandle *fHandle)
+{
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+    SM_SyncState *sync = &(mgmt->sync);
+    RC result = RC_OK;
+    pthread_mutex_lock(&(sync->lock));
+    long request = ++sync->requested;
+    sync->stats.numRequests++;
+    switch (sync->policy)
     {
-        RC result = appendEmptyBlock(fHandle);
-        if (result != RC_OK) 
-            return result;
+        case SM_SYNC_FLUSH:
+            result = _syncUpTo(mgmt, request);
+            break;
+        case SM_SYNC_GROUP:
+            // join the open window, the request that fills it up makes the whole group durable
+            if (sync->pending++ == 0) 
+                sync->firstPendingMicros = _nowMicros();
+            if (sync->pending >= sync->windowSize || !sync->threadRunning)
+            {
+                result = _syncUpTo(mgmt, request);
+                break;
+            }
+
+            // otherwise wait for the fsync that covers it (the group commit thread issues it once the time runs out)
+            pthread_cond_signal(&(sync->wake));
+            while (sync->durable < request)
+                pthread_cond_wait(&(sync->done), &(sync->lock));
+            result = sync->durableResult;
+            break;
+        default:
+            // nothing to do, the data is left to the OS
+            break;
     }
+    pthread_mutex_unlock(&(sync->lock));
+    return result;
+}
+
+RC getSyncStats (SM_FileHandle *fHandle, SM_SyncStats *stats)
+{
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)fHandle->mgmtInfo;
+    if (mgmt == NULL) return RC_FILE_HANDLE_NOT_INIT;
+    pthread_mutex_lock(&(mgmt->sync.lock));
+    *stats = mgmt->sync.stats;
+    pthread_mutex_unlock(&(mgmt->sync.lock));
     return RC_OK;
-}
\ No newline at end of file
+}
@@ -10,23 +10,62 @@ typedef struct SM_FileHandle {
 	char *fileName;
 	int totalNumPages;
 	int curPagePos;
+	int pageSize;
 	void *mgmtInfo;
 } SM_FileHandle;
 
 typedef char* SM_PageHandle;
 
+// how the page file is accessed
+typedef enum SM_FileMode {
+	SM_MODE_DEFAULT = 0, // positional reads and writes
+	SM_MODE_MMAP = 1,    // the whole file is memory-mapped, pages can be used in place with `mapBlock`
+	SM_MODE_DIRECT = 2   // positional reads and writes with O_DIRECT, bypassing the OS page cache
+} SM_FileMode;
+
+// when data written to the page file is made durable (fsync'd)
+typedef enum SM_SyncPolicy {
+	SM_SYNC_NONE = 0,  // never, the OS writes the data back whenever it likes
+	SM_SYNC_FLUSH = 1, // every sync request waits for an fsync (concurrent requests share one)
+	SM_SYNC_GROUP = 2  // sync requests are batched and fsync'd together once a time or size window fills up
+} SM_SyncPolicy;
+
+// counters kept for the sync policy
+typedef struct SM_SyncStats {
+	long numRequests;   // sync requests made by `syncPageFile`
+	long numSyncs;      // fsyncs actually issued
+	long totalSyncMicros;
+	long maxSyncMicros;
+} SM_SyncStats;
+
+// page buffers aligned to this can be used for direct I/O without a bounce copy
+#define SM_IO_ALIGNMENT 4096
+
+// page sizes are powers of two from `PAGE_SIZE` up to this
+#define SM_MAX_PAGE_SIZE (1 << 20)
+
+// limits of a segmented page file's layout
+#define SM_MAX_SEGMENT_DIRS 8
+#define SM_MAX_SEGMENTS 4096
+#define SM_MAX_PATH 256
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createPageFileSize (char *fileName, int pageSize);
+extern RC createSegmentedPageFile (char *fileName, int pageSize, int pagesPerSegment, int numDirs, char **dirs);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
+extern RC openPageFileMode (char *fileName, SM_FileHandle *fHandle, SM_FileMode mode);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
 
 /* reading blocks from disc */
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *buffers);
+extern RC mapBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle *memPage);
 extern int getBlockPos (SM_FileHandle *fHandle);
 extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
@@ -36,8 +75,16 @@ extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *buffers);
+extern RC syncBlocks (int startPage, int count, SM_FileHandle *fHandle);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC setGrowthFactor (float growthFactor, SM_FileHandle *fHandle);
+
+/* durability */
+extern RC setSyncPolicy (SM_SyncPolicy policy, int windowMicros, int windowSize, SM_FileHandle *fHandle);
+extern RC syncPageFile (SM_FileHandle *fHandle);
+extern RC getSyncStats (SM_FileHandle *fHandle, SM_SyncStats *stats);
 
 #endif
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 #include "dberror.h"
 #include "expr.h"
 #include "record_mgr.h"
@@ -56,6 +57,8 @@ static void testScans (void);
 static void testScansTwo (void);
 static void testInsertManyRecords(void);
 static void testMultipleScans(void);
+static void testNamedPools(void);
+static void testPageSizeOption(void);
 
 // struct for test records
 typedef struct TestRecord {
@@ -89,6 +92,8 @@ main (void)
 	testScans();
 	testScansTwo();
 	testMultipleScans();
+	testNamedPools();
+	testPageSizeOption();
 
 	return 0;
 }
@@ -661,6 +666,165 @@ void testScansTwo (void)
 }
 
 
+void
+testPageSizeOption(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 1000, i;
+	Record *r, *expected;
+	RID *rids;
+	RM_Options options;
+	SM_FileHandle fHandle;
+	Schema *schema;
+	testName = "test creating a database with larger pages";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	remove(PAGE_FILE_NAME);
+
+	// a new page file is created with the page size of the options
+	initRecordManagerOptions(&options);
+	options.pageSize = 4 * PAGE_SIZE;
+	TEST_CHECK(initRecordManagerWithOptions(&options));
+	TEST_CHECK(createTable("test_table_big",schema));
+	TEST_CHECK(openTable(table, "test_table_big"));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "big!", i);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(openPageFile(PAGE_FILE_NAME, &fHandle));
+	ASSERT_EQUALS_INT(4 * PAGE_SIZE, fHandle.pageSize, "the file has the page size of the options");
+	TEST_CHECK(closePageFile(&fHandle));
+
+	// an existing file keeps its page size whatever the options say
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(openTable(table, "test_table_big"));
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "every record is in the table");
+	TEST_CHECK(createRecord(&r, schema));
+	for(i = 0; i < numInserts; i += 11)
+	{
+		expected = testRecord(schema, i, "big!", i);
+		TEST_CHECK(getRecord(table, rids[i], r));
+		ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records");
+		freeRecord(expected);
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_big"));
+	TEST_CHECK(shutdownRecordManager());
+
+	// a page size the storage manager doesn't support is refused before anything is created
+	remove(PAGE_FILE_NAME);
+	options.pageSize = 3 * PAGE_SIZE;
+	ASSERT_ERROR(initRecordManagerWithOptions(&options), "page sizes are powers of two");
+	ASSERT_TRUE(access(PAGE_FILE_NAME, F_OK) != 0, "no page file was created");
+
+	freeRecord(r);
+	free(rids);
+	free(table);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+void
+testNamedPools(void)
+{
+	RM_TableData *scanned = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *hot = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 2000, i, count = 0;
+	Record *r, *expected;
+	RID *scannedRids, *hotRids;
+	RM_ScanHandle sc;
+	RM_Options options;
+	Schema *schema;
+	testName = "test tables in their own buffer pools";
+	schema = testSchema();
+	scannedRids = (RID *) malloc(sizeof(RID) * numInserts);
+	hotRids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	// one table is opened in a small pool of its own, the other in the catalog's
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_scan",schema));
+	TEST_CHECK(createTable("test_table_hot",schema));
+	initRecordManagerOptions(&options);
+	options.numPages = 4;
+	options.strategy = RS_FIFO;
+	TEST_CHECK(addBufferPool("scans", &options));
+	ASSERT_TRUE(addBufferPool("scans", &options) != RC_OK, "pool names are unique");
+	ASSERT_TRUE(openTableInPool(scanned, "test_table_scan", "nothing") != RC_OK, "the pool has to exist");
+	TEST_CHECK(openTableInPool(scanned, "test_table_scan", "scans"));
+	TEST_CHECK(openTable(hot, "test_table_hot"));
+
+	// new pages come from the catalog's pool and are then used through the table's
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "scan", i);
+		TEST_CHECK(insertRecord(scanned, r));
+		scannedRids[i] = r->id;
+		freeRecord(r);
+		r = testRecord(schema, i, "hot!", i);
+		TEST_CHECK(insertRecord(hot, r));
+		hotRids[i] = r->id;
+		freeRecord(r);
+	}
+	TEST_CHECK(createRecord(&r, schema));
+	TEST_CHECK(startScan(scanned, &sc, NULL));
+	while(next(&sc, r) == RC_OK)
+		count++;
+	TEST_CHECK(closeScan(&sc));
+	ASSERT_EQUALS_INT(numInserts, count, "the scan saw every record");
+	for(i = 0; i < numInserts; i += 7)
+	{
+		expected = testRecord(schema, i, "scan", i);
+		TEST_CHECK(getRecord(scanned, scannedRids[i], r));
+		ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records");
+		freeRecord(expected);
+	}
+
+	// the pages of a deleted table go back to the free list through the catalog's pool
+	// (deleting a table moves the catalog entries of the others, so they are closed first)
+	TEST_CHECK(closeTable(scanned));
+	TEST_CHECK(closeTable(hot));
+	TEST_CHECK(deleteTable("test_table_scan"));
+	TEST_CHECK(createTable("test_table_scan",schema));
+	TEST_CHECK(openTableInPool(scanned, "test_table_scan", "scans"));
+	for(i = 0; i < numInserts; i++)
+	{
+		expected = testRecord(schema, -i, "next", -i);
+		TEST_CHECK(insertRecord(scanned, expected));
+		freeRecord(expected);
+	}
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(scanned), "the table was filled again");
+	TEST_CHECK(closeTable(scanned));
+	TEST_CHECK(shutdownRecordManager());
+
+	// everything was written back
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(openTable(hot, "test_table_hot"));
+	for(i = 0; i < numInserts; i += 7)
+	{
+		expected = testRecord(schema, i, "hot!", i);
+		TEST_CHECK(getRecord(hot, hotRids[i], r));
+		ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records");
+		freeRecord(expected);
+	}
+	TEST_CHECK(closeTable(hot));
+	TEST_CHECK(deleteTable("test_table_hot"));
+	TEST_CHECK(deleteTable("test_table_scan"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	free(scannedRids);
+	free(hotRids);
+	free(scanned);
+	free(hot);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
 Schema *
 testSchema (void)
 {
@@ -0,0 +1,136 @@
+#include <stdlib.h>
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "async_io.h"
+#include "test_helper.h"
+#include <string.h>
+#include <stdio.h>
+
+#define TEST_FILE_NAME "TEST.bin"
+#define NUM_TEST_PAGES 64
+#define NUM_TEST_THREADS 4
+
+void testAsyncReadWrite();
+void testCallbacks();
+
+int main () 
+{
+    testAsyncReadWrite();
+    testCallbacks();
+    return 0;
+}
+
+void testAsyncReadWrite()
+{
+    char* testName = "testAsyncReadWrite";
+    SM_FileHandle fHandle;
+    AIO_Engine engine;
+    AIO_Request requests[NUM_TEST_PAGES];
+    AIO_Request syncRequest;
+    SM_PageHandle pages[NUM_TEST_PAGES];
+    remove(TEST_FILE_NAME);
+
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(NUM_TEST_PAGES, &fHandle));
+    TEST_CHECK(setSyncPolicy(SM_SYNC_FLUSH, 0, 0, &fHandle));
+    TEST_CHECK(initAsyncIO(&engine, NUM_TEST_THREADS));
+
+    // write every page with its own request, then wait on each of them
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        pages[i] = (SM_PageHandle)malloc(PAGE_SIZE);
+        memset(pages[i], 'a' + i % 26, PAGE_SIZE);
+        TEST_CHECK(asyncWriteBlocks(&engine, &requests[i], i, 1, &fHandle, &pages[i], NULL, NULL));
+    }
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        TEST_CHECK(waitRequest(&engine, &requests[i]));
+        ASSERT_TRUE(pollRequest(&engine, &requests[i]), "a waited request is done");
+    }
+
+    // a sync request after the writes completed makes them durable
+    TEST_CHECK(asyncSyncPageFile(&engine, &syncRequest, &fHandle, NULL, NULL));
+    TEST_CHECK(waitRequest(&engine, &syncRequest));
+    SM_SyncStats stats;
+    TEST_CHECK(getSyncStats(&fHandle, &stats));
+    ASSERT_EQUALS_INT(1, (int)stats.numSyncs, "the sync request fsyncs the page file");
+
+    // read the whole file back with a single multi-block request
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        memset(pages[i], 0, PAGE_SIZE);
+    TEST_CHECK(asyncReadBlocks(&engine, &requests[0], 0, NUM_TEST_PAGES, &fHandle, pages, NULL, NULL));
+    TEST_CHECK(waitRequest(&engine, &requests[0]));
+    bool matches = true;
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        matches = matches && pages[i][0] == 'a' + i % 26 && pages[i][PAGE_SIZE - 1] == 'a' + i % 26;
+    ASSERT_TRUE(matches, "pages written asynchronously are read back asynchronously");
+
+    // errors are reported through the request
+    TEST_CHECK(asyncReadBlocks(&engine, &requests[0], NUM_TEST_PAGES, 1, &fHandle, pages, NULL, NULL));
+    ASSERT_ERROR(waitRequest(&engine, &requests[0]), "reading past the end of the file fails");
+
+    ASSERT_EQUALS_INT(0, getNumInFlight(&engine), "nothing is in flight");
+    ASSERT_TRUE(getNumCompleted(&engine) == NUM_TEST_PAGES + 3, "every request completed");
+
+    // a stopped engine takes no more requests
+    TEST_CHECK(shutdownAsyncIO(&engine));
+    ASSERT_ERROR(asyncSyncPageFile(&engine, &syncRequest, &fHandle, NULL, NULL), "submitting to a stopped engine fails");
+
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        free(pages[i]);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+// counts completed reads that found the expected data
+int numVerified = 0;
+
+void verifyPage(AIO_Request *request)
+{
+    char expected = *(char *)request->userData;
+    if (request->result == RC_OK && request->buffers[0][0] == expected)
+        __atomic_fetch_add(&numVerified, 1, __ATOMIC_SEQ_CST);
+    free(request->buffers[0]);
+    free(request->buffers);
+    free(request);
+}
+
+void testCallbacks()
+{
+    char* testName = "testCallbacks";
+    SM_FileHandle fHandle;
+    AIO_Engine engine;
+    char values[NUM_TEST_PAGES];
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE);
+    remove(TEST_FILE_NAME);
+
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(NUM_TEST_PAGES, &fHandle));
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        values[i] = 'A' + i % 26;
+        memset(page, values[i], PAGE_SIZE);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(initAsyncIO(&engine, NUM_TEST_THREADS));
+
+    // fire and forget, each callback checks and releases its own request
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        AIO_Request *request = (AIO_Request *)malloc(sizeof(AIO_Request));
+        SM_PageHandle *buffers = (SM_PageHandle *)malloc(sizeof(SM_PageHandle));
+        buffers[0] = (SM_PageHandle)malloc(PAGE_SIZE);
+        TEST_CHECK(asyncReadBlocks(&engine, request, i, 1, &fHandle, buffers, verifyPage, &values[i]));
+    }
+    TEST_CHECK(drainRequests(&engine));
+    ASSERT_EQUALS_INT(NUM_TEST_PAGES, numVerified, "every callback ran once the engine drained");
+
+    TEST_CHECK(shutdownAsyncIO(&engine));
+    free(page);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
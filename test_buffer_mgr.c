@@ -0,0 +1,1487 @@
+#include <stdlib.h>
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "test_helper.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_FILE_NAME "TEST.bin"
+
+// threads and pages used by testConcurrentPins
+#define NUM_WORKERS 8
+#define NUM_SHARED_PAGES 64
+#define PINS_PER_WORKER 4000
+
+void testMappedPool();
+void testDirectPool();
+void testSortedFlush();
+void testFlushPolicy();
+void testPoolPageSize();
+void testClockStrategy();
+void testLRUKStrategy();
+void testLFUStrategy();
+void testLRUStrategy();
+void test2QStrategy();
+void testCustomPolicy();
+void testConcurrentPins();
+void testHotPagePins();
+void testBackgroundWriter();
+void testReadAhead();
+void testResizePool();
+void testFrameArena();
+void testSharedPageTable();
+void testFailedPin();
+
+int main () 
+{
+    testMappedPool();
+    testDirectPool();
+    testSortedFlush();
+    testFlushPolicy();
+    testPoolPageSize();
+    testClockStrategy();
+    testLRUKStrategy();
+    testLFUStrategy();
+    testLRUStrategy();
+    test2QStrategy();
+    testCustomPolicy();
+    testConcurrentPins();
+    testHotPagePins();
+    testBackgroundWriter();
+    testReadAhead();
+    testResizePool();
+    testFrameArena();
+    testSharedPageTable();
+    testFailedPin();
+    return 0;
+}
+
+void testMappedPool()
+{
+    char* testName = "testMappedPool";
+    BM_BufferPool bm;
+    BM_PageHandle handles[6];
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE + 1);
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+
+    // pin more pages than there are frames, mapped pools grow instead of failing
+    TEST_CHECK(initBufferPoolMode(&bm, TEST_FILE_NAME, 3, RS_FIFO, NULL, SM_MODE_MMAP));
+    for (int i = 0; i < 6; i++)
+    {
+        TEST_CHECK(pinPage(&bm, &handles[i], i));
+        sprintf(handles[i].data, "Page-%i", i);
+        TEST_CHECK(markDirty(&bm, &handles[i]));
+    }
+    ASSERT_TRUE(bm.numPages >= 6, "mapped pool grows past its initial frame count");
+    ASSERT_EQUALS_INT(0, getNumReadIO(&bm), "mapped pages are not copied in");
+
+    // the page data lives in the file's mapping, so a plain read sees it before any flush
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(readBlock(4, &fHandle, page));
+    ASSERT_EQUALS_STRING("Page-4", page, "write through a mapped handle is visible in the file");
+
+    // pinning a mapped page again hands out the same memory
+    BM_PageHandle again;
+    TEST_CHECK(pinPage(&bm, &again, 2));
+    ASSERT_TRUE(again.data == handles[2].data, "mapped page is not copied on a hit");
+    TEST_CHECK(unpinPage(&bm, &again));
+
+    for (int i = 0; i < 6; i++)
+        TEST_CHECK(unpinPage(&bm, &handles[i]));
+    TEST_CHECK(forcePage(&bm, &handles[0]));
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // the content survives the pool
+    for (int i = 0; i < 6; i++)
+    {
+        char expected[16];
+        sprintf(expected, "Page-%i", i);
+        TEST_CHECK(readBlock(i, &fHandle, page));
+        ASSERT_EQUALS_STRING(expected, page, "mapped page was written to the file");
+    }
+
+    free(page);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testDirectPool()
+{
+    char* testName = "testDirectPool";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    SM_FileHandle fHandle;
+    // (one byte more than a page, since the pages are read back one byte into it)
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE + 1);
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+
+    // write more pages than there are frames so evictions go through direct I/O
+    TEST_CHECK(initBufferPoolMode(&bm, TEST_FILE_NAME, 2, RS_LRU, NULL, SM_MODE_DIRECT));
+    for (int i = 0; i < 5; i++)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, i));
+        ASSERT_TRUE((uintptr_t)handle.data % SM_IO_ALIGNMENT == 0, "frames are aligned for direct I/O");
+        sprintf(handle.data, "Page-%i", i);
+        TEST_CHECK(markDirty(&bm, &handle));
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    ASSERT_EQUALS_INT(5, getNumReadIO(&bm), "every page was read once");
+    ASSERT_EQUALS_INT(3, getNumWriteIO(&bm), "evicted dirty pages were written");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // read the pages back into an unaligned buffer, direct handles bounce those through an aligned page
+    TEST_CHECK(openPageFileMode(TEST_FILE_NAME, &fHandle, SM_MODE_DIRECT));
+    for (int i = 0; i < 5; i++)
+    {
+        char expected[16];
+        sprintf(expected, "Page-%i", i);
+        TEST_CHECK(readBlock(i, &fHandle, page + 1));
+        ASSERT_EQUALS_STRING(expected, page + 1, "direct page was written to the file");
+    }
+
+    free(page);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testSortedFlush()
+{
+    char* testName = "testSortedFlush";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE);
+    int dirtyPages[] = { 8, 2, 5, 1, 7, 3 };
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+
+    // load pages in reverse order so frame order and page order differ
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 10, RS_FIFO, NULL));
+    for (int i = 9; i >= 0; i--)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, i));
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, dirtyPages[i]));
+        sprintf(handle.data, "Page-%i", dirtyPages[i]);
+        TEST_CHECK(markDirty(&bm, &handle));
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+
+    // pages 1-3, 5 and 7-8 are written as three runs
+    TEST_CHECK(forceFlushPool(&bm));
+    ASSERT_EQUALS_INT(3, getNumFlushRuns(&bm), "contiguous dirty pages are merged into runs");
+    ASSERT_EQUALS_INT(6, getNumWriteIO(&bm), "every dirty page was written");
+    TEST_CHECK(forceFlushPool(&bm));
+    ASSERT_EQUALS_INT(3, getNumFlushRuns(&bm), "clean pages are not flushed again");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    for (int i = 0; i < 6; i++)
+    {
+        char expected[16];
+        sprintf(expected, "Page-%i", dirtyPages[i]);
+        TEST_CHECK(readBlock(dirtyPages[i], &fHandle, page));
+        ASSERT_EQUALS_STRING(expected, page, "flushed page was written to its own block");
+    }
+
+    free(page);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+// changes one page and forces it
+typedef struct ForceWorker {
+    BM_BufferPool *bm;
+    int pageNum;
+    RC result;
+} ForceWorker;
+
+void *forceOwnPage(void *arg)
+{
+    ForceWorker *worker = (ForceWorker *)arg;
+    BM_PageHandle handle;
+    worker->result = pinPage(worker->bm, &handle, worker->pageNum);
+    if (worker->result != RC_OK) return NULL;
+    handle.data[0] = 'a' + worker->pageNum;
+    markDirty(worker->bm, &handle);
+    unpinPage(worker->bm, &handle);
+    worker->result = forcePage(worker->bm, &handle);
+    return NULL;
+}
+
+void testFlushPolicy()
+{
+    char* testName = "testFlushPolicy";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    SM_SyncStats stats;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 4, RS_LRU, NULL));
+    TEST_CHECK(setFlushPolicy(&bm, SM_SYNC_FLUSH, 0, 0));
+
+    // forcing a page fsyncs it
+    TEST_CHECK(pinPage(&bm, &handle, 0));
+    TEST_CHECK(markDirty(&bm, &handle));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(forcePage(&bm, &handle));
+    TEST_CHECK(getFlushSyncStats(&bm, &stats));
+    ASSERT_EQUALS_INT(1, (int)stats.numSyncs, "forcePage fsyncs the page file");
+
+    // a whole flush shares a single fsync
+    for (int i = 0; i < 3; i++)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, i));
+        TEST_CHECK(markDirty(&bm, &handle));
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    TEST_CHECK(forceFlushPool(&bm));
+    TEST_CHECK(getFlushSyncStats(&bm, &stats));
+    ASSERT_EQUALS_INT(2, (int)stats.numSyncs, "forceFlushPool fsyncs once");
+
+    // nothing to flush, nothing to fsync
+    TEST_CHECK(forceFlushPool(&bm));
+    TEST_CHECK(getFlushSyncStats(&bm, &stats));
+    ASSERT_EQUALS_INT(2, (int)stats.numSyncs, "a clean pool is not fsync'd");
+
+    // forces of four threads join one group (none of them holds the pool while it waits for the fsync)
+    ForceWorker workers[4];
+    pthread_t threads[4];
+    TEST_CHECK(setFlushPolicy(&bm, SM_SYNC_GROUP, 10000000, 4));
+    for (int i = 0; i < 4; i++)
+    {
+        workers[i].bm = &bm;
+        workers[i].pageNum = i;
+        pthread_create(&threads[i], NULL, forceOwnPage, &workers[i]);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQUALS_INT(RC_OK, workers[i].result, "a force returns once its group is fsync'd");
+    }
+    TEST_CHECK(getFlushSyncStats(&bm, &stats));
+    ASSERT_EQUALS_INT(3, (int)stats.numSyncs, "concurrent forces share one fsync");
+
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testPoolPageSize()
+{
+    char* testName = "testPoolPageSize";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    int pageSize = 8 * PAGE_SIZE;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFileSize(TEST_FILE_NAME, pageSize));
+
+    // frames take the page size of the file
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 2, RS_FIFO, NULL));
+    ASSERT_EQUALS_INT(pageSize, getPoolPageSize(&bm), "pool uses the file's page size");
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, i));
+        memset(handle.data, 'a' + i, pageSize);
+        TEST_CHECK(markDirty(&bm, &handle));
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // every byte of every page made it through eviction and back
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 2, RS_FIFO, NULL));
+    bool matches = true;
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, i));
+        matches = matches && handle.data[0] == 'a' + i && handle.data[pageSize - 1] == 'a' + i;
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    ASSERT_TRUE(matches, "large pages survive eviction");
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+// pin and unpin `pageNum` right away
+void touchPage(BM_BufferPool *bm, PageNumber pageNum)
+{
+    BM_PageHandle handle;
+    CHECK(pinPage(bm, &handle, pageNum));
+    CHECK(unpinPage(bm, &handle));
+}
+
+// check that the frames hold `expected`
+void checkFrames(BM_BufferPool *bm, PageNumber *expected, char *message)
+{
+    char* testName = "checkFrames";
+    PageNumber *contents = getFrameContents(bm);
+    bool matches = true;
+    for (int i = 0; i < bm->numPages; i++)
+        matches = matches && contents[i] == expected[i];
+    free(contents);
+    ASSERT_TRUE(matches, message);
+}
+
+void testClockStrategy()
+{
+    char* testName = "testClockStrategy";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 3, RS_CLOCK, NULL));
+
+    // every frame was referenced, so the hand clears all bits and comes back to the first frame
+    for (int i = 0; i < 3; i++)
+        touchPage(&bm, i);
+    touchPage(&bm, 1);
+    touchPage(&bm, 3);
+    checkFrames(&bm, (PageNumber[]){ 3, 1, 2 }, "a full sweep evicts the frame after the hand");
+
+    // page 1 was referenced since the sweep, so it gets a second chance (FIFO would evict it)
+    touchPage(&bm, 1);
+    touchPage(&bm, 4);
+    checkFrames(&bm, (PageNumber[]){ 3, 1, 4 }, "a referenced frame gets a second chance");
+    ASSERT_EQUALS_INT(5, getNumReadIO(&bm), "hits are not read");
+
+    // pinned frames are skipped, and a pool with nothing but pinned frames has no victim
+    TEST_CHECK(pinPage(&bm, &handle, 3));
+    touchPage(&bm, 5);
+    checkFrames(&bm, (PageNumber[]){ 3, 5, 4 }, "a pinned frame is never a victim");
+    BM_PageHandle pinned[2];
+    TEST_CHECK(pinPage(&bm, &pinned[0], 5));
+    TEST_CHECK(pinPage(&bm, &pinned[1], 4));
+    ASSERT_ERROR(pinPage(&bm, &handle, 6), "no victim when every frame is pinned");
+    TEST_CHECK(unpinPage(&bm, &pinned[0]));
+    TEST_CHECK(unpinPage(&bm, &pinned[1]));
+    handle.pageNum = 3;
+    TEST_CHECK(unpinPage(&bm, &handle));
+
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testLRUKStrategy()
+{
+    char* testName = "testLRUKStrategy";
+    BM_BufferPool bm;
+    int k = 0;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    ASSERT_ERROR(initBufferPool(&bm, TEST_FILE_NAME, 3, RS_LRU_K, &k), "K has to be at least 1");
+    k = 2;
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 3, RS_LRU_K, &k));
+
+    // pages 0 and 1 are referenced twice, page 2 once
+    touchPage(&bm, 0);
+    touchPage(&bm, 0);
+    touchPage(&bm, 1);
+    touchPage(&bm, 1);
+    touchPage(&bm, 2);
+    checkFrames(&bm, (PageNumber[]){ 0, 1, 2 }, "empty frames fill up in order");
+
+    // a scan only ever replaces pages with fewer than K references
+    touchPage(&bm, 3);
+    checkFrames(&bm, (PageNumber[]){ 0, 1, 3 }, "a page with one reference is evicted first");
+    touchPage(&bm, 4);
+    checkFrames(&bm, (PageNumber[]){ 0, 1, 4 }, "scan pages don't displace pages with K references");
+
+    // page 3 comes back with the reference it had before it was evicted, so it now has two
+    // and the page with the oldest second reference (page 0) goes next
+    touchPage(&bm, 3);
+    checkFrames(&bm, (PageNumber[]){ 0, 1, 3 }, "the page with one reference is evicted");
+    touchPage(&bm, 5);
+    checkFrames(&bm, (PageNumber[]){ 5, 1, 3 }, "evicted history is retained");
+
+    // pinned frames are never victims
+    BM_PageHandle pinned[3];
+    for (int i = 0; i < 3; i++)
+        TEST_CHECK(pinPage(&bm, &pinned[i], i + 6));
+    ASSERT_ERROR(pinPage(&bm, &pinned[0], 9), "no victim when every frame is pinned");
+    for (int i = 0; i < 3; i++)
+        TEST_CHECK(unpinPage(&bm, &pinned[i]));
+    touchPage(&bm, 9);
+
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testLFUStrategy()
+{
+    char* testName = "testLFUStrategy";
+    BM_BufferPool bm;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 3, RS_LFU, NULL));
+
+    // the least frequently used page is evicted
+    for (int i = 0; i < 3; i++)
+        touchPage(&bm, 0);
+    for (int i = 0; i < 2; i++)
+        touchPage(&bm, 1);
+    touchPage(&bm, 2);
+    touchPage(&bm, 3);
+    checkFrames(&bm, (PageNumber[]){ 0, 1, 3 }, "the page used once is evicted");
+
+    // on a tie the page that was unpinned first goes
+    touchPage(&bm, 3);
+    touchPage(&bm, 4);
+    checkFrames(&bm, (PageNumber[]){ 0, 4, 3 }, "least recently unpinned of the least frequently used");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // without decay, a page that was popular early on stays no matter what else happens
+    int decayInterval = 0;
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 2, RS_LFU, &decayInterval));
+    for (int i = 0; i < 8; i++)
+        touchPage(&bm, 0);
+    for (int i = 0; i < 3; i++)
+        touchPage(&bm, 1);
+    touchPage(&bm, 2);
+    checkFrames(&bm, (PageNumber[]){ 0, 2 }, "without decay the old popular page stays");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // halving every count each 4 pins brings page 0 down to page 1's count (8 -> 3)
+    decayInterval = 4;
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 2, RS_LFU, &decayInterval));
+    for (int i = 0; i < 8; i++)
+        touchPage(&bm, 0);
+    for (int i = 0; i < 3; i++)
+        touchPage(&bm, 1);
+    touchPage(&bm, 2);
+    checkFrames(&bm, (PageNumber[]){ 2, 1 }, "decay lets stale popularity expire");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testLRUStrategy()
+{
+    char* testName = "testLRUStrategy";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 3, RS_LRU, NULL));
+
+    // empty frames go first, then the least recently used page
+    for (int i = 0; i < 3; i++)
+        touchPage(&bm, i);
+    touchPage(&bm, 0);
+    touchPage(&bm, 3);
+    checkFrames(&bm, (PageNumber[]){ 0, 3, 2 }, "the least recently used page is evicted");
+
+    // marking a page dirty counts as a use, unpinning an unpinned page too
+    TEST_CHECK(pinPage(&bm, &handle, 2));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(markDirty(&bm, &handle));
+    touchPage(&bm, 4);
+    checkFrames(&bm, (PageNumber[]){ 4, 3, 2 }, "recently used pages stay");
+
+    // a pinned page is never a victim, however long ago it was pinned
+    TEST_CHECK(pinPage(&bm, &handle, 3));
+    touchPage(&bm, 5);
+    touchPage(&bm, 6);
+    checkFrames(&bm, (PageNumber[]){ 6, 3, 5 }, "the pinned page stays");
+    BM_PageHandle pinned[2];
+    TEST_CHECK(pinPage(&bm, &pinned[0], 5));
+    TEST_CHECK(pinPage(&bm, &pinned[1], 6));
+    ASSERT_ERROR(pinPage(&bm, &pinned[0], 7), "no victim when every frame is pinned");
+    TEST_CHECK(unpinPage(&bm, &pinned[0]));
+    TEST_CHECK(unpinPage(&bm, &pinned[1]));
+    TEST_CHECK(unpinPage(&bm, &handle));
+
+    // the page unpinned last is the most recently used
+    touchPage(&bm, 7);
+    checkFrames(&bm, (PageNumber[]){ 6, 3, 7 }, "unpinning counts as a use");
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void test2QStrategy()
+{
+    char* testName = "test2QStrategy";
+    BM_BufferPool bm;
+    BM_PageHandle handles[2];
+    int kIn = 1;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 4, RS_2Q, &kIn));
+
+    // pages seen once leave in the order they came in, a page that comes back while remembered stays through a scan
+    for (int i = 0; i < 5; i++)
+        touchPage(&bm, i);
+    checkFrames(&bm, (PageNumber[]){ 4, 1, 2, 3 }, "the oldest page seen once is evicted");
+    touchPage(&bm, 0);
+    for (int i = 5; i < 9; i++)
+        touchPage(&bm, i);
+    checkFrames(&bm, (PageNumber[]){ 7, 0, 8, 6 }, "the scan doesn't evict the page used twice");
+
+    // using a page while it is in A1in doesn't keep it there
+    for (int i = 0; i < 5; i++)
+        touchPage(&bm, 7);
+    touchPage(&bm, 9);
+    touchPage(&bm, 10);
+    checkFrames(&bm, (PageNumber[]){ 10, 0, 8, 9 }, "A1in is FIFO");
+    touchPage(&bm, 7);
+    touchPage(&bm, 11);
+    touchPage(&bm, 12);
+    checkFrames(&bm, (PageNumber[]){ 12, 0, 7, 11 }, "the page remembered in A1out goes to Am");
+
+    // with A1in all pinned, the least recently used page of Am goes
+    TEST_CHECK(pinPage(&bm, &handles[0], 11));
+    TEST_CHECK(pinPage(&bm, &handles[1], 12));
+    touchPage(&bm, 13);
+    checkFrames(&bm, (PageNumber[]){ 12, 13, 7, 11 }, "Am is LRU");
+    TEST_CHECK(unpinPage(&bm, &handles[0]));
+    TEST_CHECK(unpinPage(&bm, &handles[1]));
+
+    // every pin is either a hit or a miss
+    ASSERT_EQUALS_INT(16, getNumMisses(&bm), "pins that read a page");
+    ASSERT_EQUALS_INT(7, getNumHits(&bm), "pins of a page in the pool");
+    ASSERT_EQUALS_INT(getNumReadIO(&bm), getNumMisses(&bm), "every miss is a read");
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+// a most recently used policy, the kind of policy a workload that loops over more pages than fit would register
+typedef struct MRUState {
+    int numLoaded;
+    int mostRecent;
+} MRUState;
+
+void *initMRU(BM_BufferPool *const bm, void *stratData)
+{
+    MRUState *state = (MRUState *)malloc(sizeof(MRUState));
+    state->numLoaded = 0;
+    state->mostRecent = -1;
+    return state;
+}
+
+void freeMRU(BM_BufferPool *const bm, void *policyData)
+{
+    free(policyData);
+}
+
+void unpinMRU(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    ((MRUState *)policyData)->mostRecent = frameIndex;
+}
+
+void loadMRU(BM_BufferPool *const bm, void *policyData, int frameIndex, PageNumber pageNum)
+{
+    ((MRUState *)policyData)->numLoaded++;
+}
+
+int victimMRU(BM_BufferPool *const bm, void *policyData)
+{
+    MRUState *state = (MRUState *)policyData;
+
+    // fill the empty frames first, then take the page unpinned last
+    if (state->numLoaded < bm->numPages)
+        return state->numLoaded;
+    if (state->mostRecent != -1 && getFrameFixCount(bm, state->mostRecent) == 0)
+        return state->mostRecent;
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        if (getFrameFixCount(bm, i) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// register the policy `arg` (while testCustomPolicy starts a pool with it)
+void *registerPolicy(void *arg)
+{
+    ReplacementStrategy strategy;
+    registerReplacementPolicy((const BM_ReplacementPolicy *)arg, &strategy);
+    return NULL;
+}
+
+void testCustomPolicy()
+{
+    char* testName = "testCustomPolicy";
+    BM_BufferPool bm;
+    static BM_ReplacementPolicy mru = { .name = "MRU", .init = initMRU, .shutdown = freeMRU, .onUnpin = unpinMRU, 
+        .onLoad = loadMRU, .chooseVictim = victimMRU };
+    static BM_ReplacementPolicy noVictim = { .name = "none" };
+    ReplacementStrategy strategy;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+
+    // registered policies get a strategy number of their own
+    ASSERT_ERROR(registerReplacementPolicy(&noVictim, &strategy), "a policy has to choose victims");
+    TEST_CHECK(registerReplacementPolicy(&mru, &strategy));
+    ASSERT_TRUE(strategy > RS_2Q, "the built-in strategies keep their numbers");
+    ASSERT_TRUE(getReplacementPolicy(strategy) == &mru, "the strategy is bound to the policy");
+    ASSERT_TRUE(getReplacementPolicy(RS_LRU) != NULL, "the built-in strategies are policies too");
+    ASSERT_ERROR(initBufferPool(&bm, TEST_FILE_NAME, 3, (ReplacementStrategy)(RS_MAX_POLICIES - 1), NULL), 
+        "a strategy without a policy can't be used");
+
+    // the pool evicts with the registered policy
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 3, strategy, NULL));
+    for (int i = 0; i < 4; i++)
+        touchPage(&bm, i);
+    checkFrames(&bm, (PageNumber[]){ 0, 1, 3 }, "the page unpinned last is evicted");
+    touchPage(&bm, 1);
+    touchPage(&bm, 4);
+    checkFrames(&bm, (PageNumber[]){ 0, 4, 3 }, "the page used last is evicted");
+    ASSERT_EQUALS_INT(1, getNumHits(&bm), "statistics work with any policy");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // a policy can be registered while another thread is starting a pool with its strategy
+    pthread_t thread;
+    pthread_create(&thread, NULL, registerPolicy, &mru);
+    while (initBufferPool(&bm, TEST_FILE_NAME, 3, (ReplacementStrategy)(strategy + 1), NULL) != RC_OK);
+    pthread_join(thread, NULL);
+    ASSERT_TRUE(getReplacementPolicy((ReplacementStrategy)(strategy + 1)) == &mru, "the pool got the policy registered");
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+// what a thread of testConcurrentPins works with
+typedef struct PinWorker {
+    BM_BufferPool *bm;
+    pthread_barrier_t *start;
+    unsigned int seed;
+    int errors;
+} PinWorker;
+
+// pin the first page as soon as every worker is ready
+void *pinFirstPage(void *arg)
+{
+    PinWorker *worker = (PinWorker *)arg;
+    BM_PageHandle handle;
+    pthread_barrier_wait(worker->start);
+    if (pinPage(worker->bm, &handle, 0) != RC_OK || strcmp(handle.data, "Page-0") != 0)
+        worker->errors++;
+    else if (unpinPage(worker->bm, &handle) != RC_OK)
+        worker->errors++;
+    return NULL;
+}
+
+// pin random pages and check each one holds its own page
+void *pinRandomPages(void *arg)
+{
+    PinWorker *worker = (PinWorker *)arg;
+    BM_PageHandle handle;
+    char expected[32];
+    pthread_barrier_wait(worker->start);
+    for (int i = 0; i < PINS_PER_WORKER; i++)
+    {
+        int pageNum = rand_r(&(worker->seed)) % NUM_SHARED_PAGES;
+        sprintf(expected, "Page-%i", pageNum);
+        if (pinPage(worker->bm, &handle, pageNum) != RC_OK)
+        {
+            worker->errors++;
+            continue;
+        }
+        if (strcmp(handle.data, expected) != 0)
+            worker->errors++;
+
+        // dirty the page now and then so evictions write pages back while others read them
+        if (i % 4 == 0 && markDirty(worker->bm, &handle) != RC_OK)
+            worker->errors++;
+        if (unpinPage(worker->bm, &handle) != RC_OK)
+            worker->errors++;
+    }
+    return NULL;
+}
+
+// run `count` workers with `routine` on the pool and return how many errors they saw
+int runWorkers(BM_BufferPool *bm, void *(*routine)(void *), int count)
+{
+    pthread_t threads[NUM_WORKERS];
+    PinWorker workers[NUM_WORKERS];
+    pthread_barrier_t start;
+    int errors = 0;
+    pthread_barrier_init(&start, NULL, count);
+    for (int i = 0; i < count; i++)
+    {
+        workers[i].bm = bm;
+        workers[i].start = &start;
+        workers[i].seed = i + 1;
+        workers[i].errors = 0;
+        pthread_create(&threads[i], NULL, routine, &workers[i]);
+    }
+    for (int i = 0; i < count; i++)
+    {
+        pthread_join(threads[i], NULL);
+        errors += workers[i].errors;
+    }
+    pthread_barrier_destroy(&start);
+    return errors;
+}
+
+void testConcurrentPins()
+{
+    char* testName = "testConcurrentPins";
+    BM_BufferPool bm;
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)calloc(PAGE_SIZE, 1);
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(NUM_SHARED_PAGES, &fHandle));
+    for (int i = 0; i < NUM_SHARED_PAGES; i++)
+    {
+        sprintf(page, "Page-%i", i);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // threads that miss on the same page at once wait for one read
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 16, RS_LRU, NULL));
+    int errors = runWorkers(&bm, pinFirstPage, NUM_WORKERS);
+    ASSERT_EQUALS_INT(0, errors, "every thread sees the page");
+    ASSERT_EQUALS_INT(1, getNumReadIO(&bm), "the page is read once");
+    ASSERT_EQUALS_INT(1, getNumMisses(&bm), "one thread missed");
+    ASSERT_EQUALS_INT(NUM_WORKERS - 1, getNumHits(&bm), "the others waited for its read");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // many threads pinning more pages than fit never see the wrong page, with every policy
+    // (and the background writer cleaning frames under them)
+    for (ReplacementStrategy strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+    {
+        TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 16, strategy, NULL));
+        TEST_CHECK(startBackgroundWriter(&bm, 4, 100));
+        errors = runWorkers(&bm, pinRandomPages, NUM_WORKERS);
+        ASSERT_EQUALS_INT(0, errors, "every pin got its own page");
+        ASSERT_EQUALS_INT(NUM_WORKERS * PINS_PER_WORKER, getNumHits(&bm) + getNumMisses(&bm), "every pin was counted");
+        int *fixCounts = getFixCounts(&bm);
+        bool unpinned = true;
+        for (int i = 0; i < bm.numPages; i++)
+            unpinned = unpinned && fixCounts[i] == 0;
+        free(fixCounts);
+        ASSERT_TRUE(unpinned, "every pin was undone");
+        TEST_CHECK(shutdownBufferPool(&bm));
+    }
+
+    // the pages written back are intact
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    for (int i = 0; i < NUM_SHARED_PAGES; i++)
+    {
+        char expected[32];
+        sprintf(expected, "Page-%i", i);
+        TEST_CHECK(readBlock(i, &fHandle, page));
+        ASSERT_EQUALS_STRING(expected, page, "written back pages are intact");
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    free(page);
+    TEST_DONE();
+}
+
+// pin and unpin the first page over and over while the test keeps it pinned
+void *pinHotPage(void *arg)
+{
+    PinWorker *worker = (PinWorker *)arg;
+    BM_PageHandle handle;
+    pthread_barrier_wait(worker->start);
+    for (int i = 0; i < PINS_PER_WORKER; i++)
+    {
+        if (pinPage(worker->bm, &handle, 0) != RC_OK || strcmp(handle.data, "Page-0") != 0)
+            worker->errors++;
+        else if (unpinPage(worker->bm, &handle) != RC_OK)
+            worker->errors++;
+    }
+    return NULL;
+}
+
+// LRU that counts the hits it is told about
+static int countedHits = 0;
+
+void countHitLRU(BM_BufferPool *const bm, void *policyData, int frameIndex)
+{
+    countedHits++;
+    getReplacementPolicy(RS_LRU)->onHit(bm, policyData, frameIndex);
+}
+
+void testHotPagePins()
+{
+    char* testName = "testHotPagePins";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)calloc(PAGE_SIZE, 1);
+    static BM_ReplacementPolicy countingLRU;
+    ReplacementStrategy strategy;
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    sprintf(page, "Page-0");
+    TEST_CHECK(writeBlock(0, &fHandle, page));
+    TEST_CHECK(closePageFile(&fHandle));
+    countingLRU = *getReplacementPolicy(RS_LRU);
+    countingLRU.name = "counting LRU";
+    countingLRU.onHit = countHitLRU;
+    TEST_CHECK(registerReplacementPolicy(&countingLRU, &strategy));
+
+    // a page that stays pinned is pinned again by many threads at once
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 4, strategy, NULL));
+    TEST_CHECK(pinPage(&bm, &handle, 0));
+    int errors = runWorkers(&bm, pinHotPage, NUM_WORKERS);
+    ASSERT_EQUALS_INT(0, errors, "every pin of the hot page got it");
+    ASSERT_EQUALS_INT(NUM_WORKERS * PINS_PER_WORKER, getNumHits(&bm), "every pin of the hot page was a hit");
+    ASSERT_EQUALS_INT(NUM_WORKERS * PINS_PER_WORKER, countedHits, "the policy was told about every hit");
+    ASSERT_EQUALS_INT(1, getFrameFixCount(&bm, 0), "only the test's pin is left");
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    free(page);
+    TEST_DONE();
+}
+
+void testBackgroundWriter()
+{
+    char* testName = "testBackgroundWriter";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    BM_WriterStats stats;
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)calloc(PAGE_SIZE, 1);
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+
+    // with every policy, the writer cleans the next victims so the misses that evict them don't write
+    for (ReplacementStrategy strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+    {
+        TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 8, strategy, NULL));
+        for (int i = 0; i < 8; i++)
+        {
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            sprintf(handle.data, "Page-%i-%i", i, strategy);
+            TEST_CHECK(markDirty(&bm, &handle));
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+        TEST_CHECK(startBackgroundWriter(&bm, 4, 1000));
+        ASSERT_TRUE(startBackgroundWriter(&bm, 4, 1000) != RC_OK, "a pool has one writer");
+        TEST_CHECK(getWriterStats(&bm, &stats));
+        for (int wait = 0; wait < 2000 && stats.numCleaned < 4; wait++)
+        {
+            usleep(1000);
+            TEST_CHECK(getWriterStats(&bm, &stats));
+        }
+        ASSERT_EQUALS_INT(4, (int)stats.numCleaned, "the writer cleans as many frames as asked");
+        ASSERT_EQUALS_INT(4, stats.numDirty, "the other frames stay dirty");
+        ASSERT_TRUE(stats.dirtyRatio == 0.5, "half the frames are dirty");
+        for (int i = 8; i < 12; i++)
+        {
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+        TEST_CHECK(getWriterStats(&bm, &stats));
+        ASSERT_EQUALS_INT(0, (int)stats.numEvictionWrites, "the victims were already clean");
+        TEST_CHECK(stopBackgroundWriter(&bm));
+        TEST_CHECK(shutdownBufferPool(&bm));
+
+        // what the writer and the shutdown wrote is on disk
+        TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+        for (int i = 0; i < 8; i++)
+        {
+            char expected[32];
+            sprintf(expected, "Page-%i-%i", i, strategy);
+            TEST_CHECK(readBlock(i, &fHandle, page));
+            ASSERT_EQUALS_STRING(expected, page, "cleaned pages are written");
+        }
+        TEST_CHECK(closePageFile(&fHandle));
+    }
+
+    // mapped pages are written back by the OS
+    TEST_CHECK(initBufferPoolMode(&bm, TEST_FILE_NAME, 8, RS_LRU, NULL, SM_MODE_MMAP));
+    ASSERT_TRUE(startBackgroundWriter(&bm, 4, 1000) != RC_OK, "a mapped pool has no writer");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    free(page);
+    TEST_DONE();
+}
+
+void testReadAhead()
+{
+    char* testName = "testReadAhead";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    BM_ReadAheadStats stats;
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)calloc(PAGE_SIZE, 1);
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(NUM_SHARED_PAGES, &fHandle));
+    for (int i = 0; i < NUM_SHARED_PAGES; i++)
+    {
+        sprintf(page, "Page-%i", i);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // with every policy, a sequential scan only misses until the run is noticed, then the window grows 
+    // with each page read ahead that is used (up to a quarter of the pool)
+    for (ReplacementStrategy strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+    {
+        TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 16, strategy, NULL));
+        TEST_CHECK(setReadAhead(&bm, 8));
+        for (int i = 0; i < 32; i++)
+        {
+            char expected[32];
+            sprintf(expected, "Page-%i", i);
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            ASSERT_EQUALS_STRING(expected, handle.data, "pages read ahead hold their page");
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+        TEST_CHECK(getReadAheadStats(&bm, &stats));
+        ASSERT_EQUALS_INT(2, getNumMisses(&bm), "only the first two pages miss");
+        ASSERT_EQUALS_INT(30, (int)stats.numUsed, "every other page was read ahead");
+        ASSERT_EQUALS_INT(4, stats.window, "the window grows to a quarter of the pool");
+        TEST_CHECK(shutdownBufferPool(&bm));
+    }
+
+    // pages asked for ahead of time are hits, and the ones read ahead for nothing shrink the window
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 16, RS_LRU, NULL));
+    TEST_CHECK(setReadAhead(&bm, 8));
+    TEST_CHECK(prefetchPages(&bm, 8, 4));
+    for (int i = 8; i < 12; i++)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, i));
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    ASSERT_EQUALS_INT(0, getNumMisses(&bm), "the pages asked for were read ahead");
+
+    // (the pages read ahead past the run stay pinned until their reads are done)
+    bool unpinned = false;
+    for (int wait = 0; wait < 2000 && !unpinned; wait++)
+    {
+        int *fixCounts = getFixCounts(&bm);
+        unpinned = true;
+        for (int i = 0; i < bm.numPages; i++)
+            unpinned = unpinned && fixCounts[i] == 0;
+        free(fixCounts);
+        if (!unpinned) usleep(1000);
+    }
+    for (int i = NUM_SHARED_PAGES - 1; i >= NUM_SHARED_PAGES - 16; i--)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, i));
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    TEST_CHECK(getReadAheadStats(&bm, &stats));
+    ASSERT_EQUALS_INT(4, (int)stats.numWasted, "the pages past the run were never used");
+    ASSERT_EQUALS_INT(2, stats.window, "a scan going backwards isn't read ahead");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // mapped pages are read ahead by the OS
+    TEST_CHECK(initBufferPoolMode(&bm, TEST_FILE_NAME, 16, RS_LRU, NULL, SM_MODE_MMAP));
+    ASSERT_TRUE(setReadAhead(&bm, 8) != RC_OK, "a mapped pool doesn't read ahead");
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    free(page);
+    TEST_DONE();
+}
+
+// resize the pool back and forth while the workers pin pages (a resize that would drop a pinned page fails)
+void *resizePool(void *arg)
+{
+    PinWorker *worker = (PinWorker *)arg;
+    pthread_barrier_wait(worker->start);
+    for (int i = 0; i < PINS_PER_WORKER / 40; i++)
+    {
+        RC result = resizeBufferPool(worker->bm, 8 + rand_r(&(worker->seed)) % 24);
+        if (result != RC_OK && result != RC_WRITE_FAILED)
+            worker->errors++;
+    }
+    return NULL;
+}
+
+// half the workers pin random pages, the others resize the pool
+void *pinOrResize(void *arg)
+{
+    PinWorker *worker = (PinWorker *)arg;
+    if (worker->seed % 2 == 0)
+        return resizePool(arg);
+    return pinRandomPages(arg);
+}
+
+void testResizePool()
+{
+    char* testName = "testResizePool";
+    BM_BufferPool bm;
+    BM_PageHandle handle, pinned;
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)calloc(PAGE_SIZE, 1);
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(NUM_SHARED_PAGES, &fHandle));
+    for (int i = 0; i < NUM_SHARED_PAGES; i++)
+    {
+        sprintf(page, "Page-%i", i);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // with every policy, growing adds empty frames and shrinking evicts the pages of the frames that go,
+    // while a pinned page stays where its handle points
+    for (ReplacementStrategy strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+    {
+        TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 4, strategy, NULL));
+        TEST_CHECK(pinPage(&bm, &pinned, 0));
+        for (int i = 1; i < 4; i++)
+        {
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            sprintf(handle.data, "Page-%i-%i", i, strategy);
+            TEST_CHECK(markDirty(&bm, &handle));
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+        TEST_CHECK(resizeBufferPool(&bm, 8));
+        ASSERT_EQUALS_INT(8, bm.numPages, "the pool grew");
+        for (int i = 4; i < 8; i++)
+        {
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+        ASSERT_EQUALS_INT(0, getNumWriteIO(&bm), "the new frames were used before evicting anything");
+        ASSERT_EQUALS_INT(8, getNumMisses(&bm), "the statistics were kept");
+
+        // the first frame holds the pinned page, so the pool can shrink down to it
+        ASSERT_TRUE(resizeBufferPool(&bm, 0) != RC_OK, "a pool has at least one frame");
+        TEST_CHECK(resizeBufferPool(&bm, 1));
+        ASSERT_EQUALS_INT(1, bm.numPages, "the pool shrank");
+        ASSERT_EQUALS_INT(3, getNumWriteIO(&bm), "the dirty pages were written back");
+        ASSERT_EQUALS_STRING("Page-0", pinned.data, "the pinned page's handle is still good");
+        ASSERT_TRUE(pinPage(&bm, &handle, 1) != RC_OK, "the only frame is pinned");
+        TEST_CHECK(unpinPage(&bm, &pinned));
+
+        // the retired frames come back
+        TEST_CHECK(resizeBufferPool(&bm, 6));
+        for (int i = 0; i < 12; i++)
+        {
+            char expected[32];
+            if (i > 0 && i < 4) sprintf(expected, "Page-%i-%i", i, strategy);
+            else sprintf(expected, "Page-%i", i);
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            ASSERT_EQUALS_STRING(expected, handle.data, "pages are read back after a resize");
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+        TEST_CHECK(shutdownBufferPool(&bm));
+    }
+
+    // a page pinned in a frame that would go moves (with its frame) into one that stays
+    for (ReplacementStrategy strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+    {
+        char expected[32];
+        TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 4, strategy, NULL));
+        for (int i = 0; i < 4; i++)
+        {
+            TEST_CHECK(pinPage(&bm, &pinned, i));
+            if (i < 3) TEST_CHECK(unpinPage(&bm, &pinned));
+        }
+        sprintf(pinned.data, "Page-3-%i", strategy);
+        TEST_CHECK(markDirty(&bm, &pinned));
+        TEST_CHECK(resizeBufferPool(&bm, 2));
+        ASSERT_EQUALS_INT(2, bm.numPages, "the pool shrank past the pinned frame");
+        PageNumber *contents = getFrameContents(&bm);
+        int *fixCounts = getFixCounts(&bm);
+        bool *dirtyFlags = getDirtyFlags(&bm);
+        int frame = (contents[0] == 3) ? 0 : 1;
+        ASSERT_EQUALS_INT(3, contents[frame], "the pinned page is in a frame that stayed");
+        ASSERT_EQUALS_INT(1, fixCounts[frame], "the pinned page is still pinned");
+        ASSERT_TRUE(dirtyFlags[frame], "the pinned page is still dirty");
+        free(contents);
+        free(fixCounts);
+        free(dirtyFlags);
+
+        // its handle still works, and it is found in its new frame
+        sprintf(expected, "Page-3-%i", strategy);
+        ASSERT_EQUALS_STRING(expected, pinned.data, "the pinned page's handle is still good");
+        TEST_CHECK(pinPage(&bm, &handle, 3));
+        ASSERT_TRUE(handle.data == pinned.data, "the page is pinned again in the frame it moved to");
+        TEST_CHECK(unpinPage(&bm, &handle));
+        TEST_CHECK(unpinPage(&bm, &pinned));
+        for (int i = 0; i < 6; i++)
+        {
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+        TEST_CHECK(pinPage(&bm, &handle, 3));
+        ASSERT_EQUALS_STRING(expected, handle.data, "the moved page was written back");
+        TEST_CHECK(unpinPage(&bm, &handle));
+        TEST_CHECK(shutdownBufferPool(&bm));
+    }
+
+    // but the pool can't shrink by more frames than are unpinned
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 4, RS_LRU, NULL));
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_CHECK(pinPage(&bm, &handle, i));
+        if (i == 0) TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    ASSERT_TRUE(resizeBufferPool(&bm, 2) != RC_OK, "only one frame is unpinned");
+    ASSERT_EQUALS_INT(4, bm.numPages, "the pool didn't change");
+    TEST_CHECK(resizeBufferPool(&bm, 3));
+    for (int i = 1; i < 4; i++)
+    {
+        handle.pageNum = i;
+        TEST_CHECK(unpinPage(&bm, &handle));
+    }
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // pins racing resizes always get their own page
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    for (int i = 1; i < 4; i++)
+    {
+        sprintf(page, "Page-%i", i);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+    for (ReplacementStrategy strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+    {
+        TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 16, strategy, NULL));
+        TEST_CHECK(startBackgroundWriter(&bm, 4, 100));
+        int errors = runWorkers(&bm, pinOrResize, NUM_WORKERS);
+        ASSERT_EQUALS_INT(0, errors, "every pin got its own page");
+        TEST_CHECK(shutdownBufferPool(&bm));
+    }
+
+    // the pages written back are intact
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    for (int i = 0; i < NUM_SHARED_PAGES; i++)
+    {
+        char expected[32];
+        sprintf(expected, "Page-%i", i);
+        TEST_CHECK(readBlock(i, &fHandle, page));
+        ASSERT_EQUALS_STRING(expected, page, "written back pages are intact");
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    free(page);
+    TEST_DONE();
+}
+
+void testFrameArena()
+{
+    char* testName = "testFrameArena";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)calloc(PAGE_SIZE, 1);
+    char *pages[NUM_SHARED_PAGES];
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(NUM_SHARED_PAGES, &fHandle));
+    for (int i = 0; i < NUM_SHARED_PAGES; i++)
+    {
+        sprintf(page, "Page-%i", i);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // whatever memory backs them, the frames of a new pool are one run of pages
+    for (BM_FrameMemory memory = BM_MEMORY_DEFAULT; memory <= BM_MEMORY_HUGETLB; memory++)
+    {
+        SM_FileMode mode = (memory == BM_MEMORY_THP) ? SM_MODE_DIRECT : SM_MODE_DEFAULT;
+        TEST_CHECK(initBufferPoolMemory(&bm, TEST_FILE_NAME, 16, RS_LRU, NULL, mode, memory));
+        ASSERT_TRUE(getFrameMemory(&bm) <= memory, "the arena got the memory asked for or less");
+        char *first = NULL, *last = NULL;
+        for (int i = 0; i < 16; i++)
+        {
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            pages[i] = handle.data;
+            if (first == NULL || handle.data < first) first = handle.data;
+            if (last == NULL || handle.data > last) last = handle.data;
+        }
+        ASSERT_TRUE(last - first == 15 * PAGE_SIZE, "the frames are contiguous");
+        ASSERT_TRUE((uintptr_t)first % 4096 == 0, "the arena is aligned for direct I/O");
+        if (getFrameMemory(&bm) != BM_MEMORY_DEFAULT)
+            ASSERT_TRUE((uintptr_t)first % (2 * 1024 * 1024) == 0, "a huge page arena is aligned to huge pages");
+        for (int i = 0; i < 16; i++)
+        {
+            handle.pageNum = i;
+            handle.data = pages[i];
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+
+        // frames a shrink retired get their place in the arena back, and frames added past it work as before
+        TEST_CHECK(resizeBufferPool(&bm, 4));
+        TEST_CHECK(resizeBufferPool(&bm, 24));
+        for (int i = 0; i < 48; i++)
+        {
+            char expected[32];
+            sprintf(expected, "Page-%i", i);
+            TEST_CHECK(pinPage(&bm, &handle, i));
+            ASSERT_EQUALS_STRING(expected, handle.data, "pages are read into the arena after a resize");
+            TEST_CHECK(unpinPage(&bm, &handle));
+        }
+        TEST_CHECK(shutdownBufferPool(&bm));
+    }
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    free(page);
+    TEST_DONE();
+}
+
+// how many times each worker of testSharedPageTable added to each page
+int sharedCounts[NUM_WORKERS][NUM_SHARED_PAGES];
+
+// pin random pages through either of two pools (`bm` points to both), each worker counting up its own int in the page
+void *pinThroughPools(void *arg)
+{
+    PinWorker *worker = (PinWorker *)arg;
+    int index = worker->seed - 1;
+    BM_PageHandle handle;
+    pthread_barrier_wait(worker->start);
+    for (int i = 0; i < PINS_PER_WORKER; i++)
+    {
+        BM_BufferPool *bm = &(worker->bm[rand_r(&(worker->seed)) % 2]);
+        int pageNum = rand_r(&(worker->seed)) % NUM_SHARED_PAGES;
+        if (pinPage(bm, &handle, pageNum) != RC_OK)
+        {
+            worker->errors++;
+            continue;
+        }
+        ((int *)(handle.data + 64))[index]++;
+        sharedCounts[index][pageNum]++;
+        if (markDirty(bm, &handle) != RC_OK || unpinPage(bm, &handle) != RC_OK)
+            worker->errors++;
+    }
+    return NULL;
+}
+
+void testSharedPageTable()
+{
+    char* testName = "testSharedPageTable";
+    BM_SharedPageTable table;
+    BM_BufferPool pools[2], other;
+    BM_PageHandle handle;
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)calloc(PAGE_SIZE, 1);
+    remove(TEST_FILE_NAME);
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(NUM_SHARED_PAGES, &fHandle));
+    for (int i = 0; i < NUM_SHARED_PAGES; i++)
+    {
+        sprintf(page, "Page-%i", i);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // pools can be attached while the pages they read ahead are still being read in
+    for (int round = 0; round < 20; round++)
+    {
+        TEST_CHECK(initSharedPageTable(&table));
+        for (int i = 0; i < 2; i++)
+        {
+            TEST_CHECK(initBufferPool(&pools[i], TEST_FILE_NAME, 16, RS_LRU, NULL));
+            TEST_CHECK(setReadAhead(&pools[i], 8));
+            TEST_CHECK(prefetchPages(&pools[i], i * 8, 8));
+            TEST_CHECK(attachBufferPool(&pools[i], &table));
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            char expected[32];
+            sprintf(expected, "Page-%i", i);
+            TEST_CHECK(pinPage(&pools[(i + round) % 2], &handle, i));
+            ASSERT_EQUALS_STRING(expected, handle.data, "pages read ahead before attaching are intact");
+            TEST_CHECK(unpinPage(&pools[(i + round) % 2], &handle));
+        }
+        TEST_CHECK(shutdownBufferPool(&pools[round % 2]));
+        TEST_CHECK(shutdownBufferPool(&pools[(round + 1) % 2]));
+        TEST_CHECK(shutdownSharedPageTable(&table));
+    }
+
+    // a page cached in one pool is pinned there through the other (and not read again)
+    TEST_CHECK(initSharedPageTable(&table));
+    TEST_CHECK(initBufferPool(&pools[0], TEST_FILE_NAME, 4, RS_LRU, NULL));
+    TEST_CHECK(initBufferPool(&pools[1], TEST_FILE_NAME, 4, RS_FIFO, NULL));
+    TEST_CHECK(attachBufferPool(&pools[0], &table));
+    TEST_CHECK(attachBufferPool(&pools[1], &table));
+    ASSERT_TRUE(attachBufferPool(&pools[1], &table) != RC_OK, "a pool is attached once");
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_CHECK(pinPage(&pools[0], &handle, i));
+        sprintf(handle.data, "Page-%i-changed", i);
+        TEST_CHECK(markDirty(&pools[0], &handle));
+        TEST_CHECK(unpinPage(&pools[0], &handle));
+    }
+    TEST_CHECK(pinPage(&pools[1], &handle, 2));
+    ASSERT_EQUALS_STRING("Page-2-changed", handle.data, "the other pool's copy is pinned");
+    TEST_CHECK(markDirty(&pools[1], &handle));
+    TEST_CHECK(unpinPage(&pools[1], &handle));
+    ASSERT_EQUALS_INT(0, getNumReadIO(&pools[1]), "the page wasn't read into the second pool");
+
+    // a scan through one pool doesn't evict the pages of the other
+    for (int i = 4; i < 20; i++)
+    {
+        TEST_CHECK(pinPage(&pools[1], &handle, i));
+        TEST_CHECK(unpinPage(&pools[1], &handle));
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_CHECK(pinPage(&pools[0], &handle, i));
+        TEST_CHECK(unpinPage(&pools[0], &handle));
+    }
+    ASSERT_EQUALS_INT(4, getNumMisses(&pools[0]), "the first pool kept its pages");
+
+    // a pool caching a page of the table can't join it, nor can a pool over another file
+    TEST_CHECK(initBufferPool(&other, TEST_FILE_NAME, 4, RS_LRU, NULL));
+    TEST_CHECK(pinPage(&other, &handle, 0));
+    TEST_CHECK(unpinPage(&other, &handle));
+    ASSERT_TRUE(attachBufferPool(&other, &table) != RC_OK, "the page is cached in the table already");
+    TEST_CHECK(shutdownBufferPool(&other));
+    TEST_CHECK(createPageFile("OTHER.bin"));
+    TEST_CHECK(initBufferPool(&other, "OTHER.bin", 4, RS_LRU, NULL));
+    ASSERT_TRUE(attachBufferPool(&other, &table) != RC_OK, "the pools of a table share a file");
+    TEST_CHECK(shutdownBufferPool(&other));
+    TEST_CHECK(destroyPageFile("OTHER.bin"));
+    TEST_CHECK(initBufferPoolMode(&other, TEST_FILE_NAME, 4, RS_LRU, NULL, SM_MODE_MMAP));
+    ASSERT_TRUE(attachBufferPool(&other, &table) != RC_OK, "the pools of a table open the file the same way");
+    TEST_CHECK(shutdownBufferPool(&other));
+
+    // the pools go through one file handle, so a page one of them appends is there for the others
+    ASSERT_TRUE(pools[0].pageFile == pools[1].pageFile, "the pools share a file handle");
+    TEST_CHECK(pinPage(&pools[0], &handle, NUM_SHARED_PAGES));
+    sprintf(handle.data, "Page-%i", NUM_SHARED_PAGES);
+    TEST_CHECK(markDirty(&pools[0], &handle));
+    TEST_CHECK(unpinPage(&pools[0], &handle));
+    TEST_CHECK(forcePage(&pools[0], &handle));
+    ASSERT_EQUALS_INT(NUM_SHARED_PAGES + 1, ((SM_FileHandle *)pools[1].pageFile)->totalNumPages, 
+        "the other pool sees the appended page");
+
+    // once a pool is shut down its pages are read from the file by the others
+    ASSERT_TRUE(shutdownSharedPageTable(&table) != RC_OK, "the table still has pools");
+    TEST_CHECK(shutdownBufferPool(&pools[0]));
+    TEST_CHECK(pinPage(&pools[1], &handle, 3));
+    ASSERT_EQUALS_STRING("Page-3-changed", handle.data, "the page was written back");
+    TEST_CHECK(unpinPage(&pools[1], &handle));
+    TEST_CHECK(shutdownBufferPool(&pools[1]));
+    TEST_CHECK(shutdownSharedPageTable(&table));
+
+    // threads pinning and changing pages through both pools never lose an update to a second copy
+    TEST_CHECK(initSharedPageTable(&table));
+    TEST_CHECK(initBufferPool(&pools[0], TEST_FILE_NAME, 10, RS_CLOCK, NULL));
+    TEST_CHECK(initBufferPool(&pools[1], TEST_FILE_NAME, 12, RS_2Q, NULL));
+    TEST_CHECK(attachBufferPool(&pools[0], &table));
+    TEST_CHECK(attachBufferPool(&pools[1], &table));
+    TEST_CHECK(startBackgroundWriter(&pools[1], 4, 100));
+    memset(sharedCounts, 0, sizeof(sharedCounts));
+    int errors = runWorkers(pools, pinThroughPools, NUM_WORKERS);
+    ASSERT_EQUALS_INT(0, errors, "every pin got its page");
+    TEST_CHECK(shutdownBufferPool(&pools[0]));
+    TEST_CHECK(shutdownBufferPool(&pools[1]));
+    TEST_CHECK(shutdownSharedPageTable(&table));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    int lost = 0;
+    for (int i = 0; i < NUM_SHARED_PAGES; i++)
+    {
+        TEST_CHECK(readBlock(i, &fHandle, page));
+        for (int j = 0; j < NUM_WORKERS; j++)
+        {
+            if (((int *)(page + 64))[j] != sharedCounts[j][i])
+                lost++;
+        }
+    }
+    ASSERT_EQUALS_INT(0, lost, "every update was written back");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    free(page);
+    TEST_DONE();
+}
+
+void testFailedPin()
+{
+    char* testName = "testFailedPin";
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    BM_PageHandle pinned;
+    char *dirs[] = { "SEG_A", "SEG_B" };
+    mkdir(dirs[0], 0755);
+    remove(TEST_FILE_NAME);
+
+    // one page per segment, and the second directory is missing, so page 1 can't be read in
+    TEST_CHECK(createSegmentedPageFile(TEST_FILE_NAME, PAGE_SIZE, 1, 2, dirs));
+    for (ReplacementStrategy strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+    {
+        TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 3, strategy, NULL));
+        TEST_CHECK(pinPage(&bm, &pinned, 0));
+
+        // a pin that fails leaves nothing behind, so failing more often than there are frames still works
+        for (int i = 0; i < 6; i++)
+            ASSERT_ERROR(pinPage(&bm, &handle, 1), "a page that can't be read in can't be pinned");
+        PageNumber *contents = getFrameContents(&bm);
+        int *fixCounts = getFixCounts(&bm);
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_TRUE(contents[i] == 0 || contents[i] == NO_PAGE, "the page that failed isn't in the pool");
+            ASSERT_EQUALS_INT((contents[i] == 0) ? 1 : 0, fixCounts[i], "the failed pins were given back");
+        }
+        free(contents);
+        free(fixCounts);
+
+        // and the frames are victims again, so the two others hold two more pages once they can be read in
+        mkdir(dirs[1], 0755);
+        TEST_CHECK(pinPage(&bm, &handle, 1));
+        ASSERT_EQUALS_INT(1, handle.pageNum, "the page is pinned once it can be read in");
+        TEST_CHECK(pinPage(&bm, &handle, 2));
+        ASSERT_EQUALS_INT(2, handle.pageNum, "every frame can still be used");
+        TEST_CHECK(unpinPage(&bm, &handle));
+        handle.pageNum = 1;
+        TEST_CHECK(unpinPage(&bm, &handle));
+        TEST_CHECK(unpinPage(&bm, &pinned));
+        TEST_CHECK(shutdownBufferPool(&bm));
+        TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+        rmdir(dirs[1]);
+        TEST_CHECK(createSegmentedPageFile(TEST_FILE_NAME, PAGE_SIZE, 1, 2, dirs));
+    }
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    rmdir(dirs[0]);
+
+    // pages read ahead from a file that was cut short behind the pool's back leave the pool once their reads fail
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(initBufferPool(&bm, TEST_FILE_NAME, 8, RS_LRU, NULL));
+    TEST_CHECK(pinPage(&bm, &handle, 7));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(forceFlushPool(&bm));
+    ASSERT_TRUE(truncate(TEST_FILE_NAME, 0) == 0, "the file was cut short");
+    TEST_CHECK(prefetchPages(&bm, 0, 4));
+    bool failed = false;
+    for (int wait = 0; wait < 2000 && !failed; wait++)
+    {
+        PageNumber *contents = getFrameContents(&bm);
+        int *fixCounts = getFixCounts(&bm);
+        failed = true;
+        for (int i = 0; i < bm.numPages; i++)
+            failed = failed && fixCounts[i] == 0 && (contents[i] == NO_PAGE || contents[i] == 7);
+        free(contents);
+        free(fixCounts);
+        if (!failed) usleep(1000);
+    }
+    ASSERT_TRUE(failed, "the pages that couldn't be read ahead aren't in the pool");
+    ASSERT_ERROR(pinPage(&bm, &handle, 0), "a page that couldn't be read ahead can't be pinned either");
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
@@ -0,0 +1,425 @@
+#include <stdlib.h>
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "dt.h"
+#include "test_helper.h"
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#define TEST_FILE_NAME "TEST.bin"
+#define NUM_TEST_PAGES 8
+
+void testVectoredBlocks();
+void testGrowth();
+void testLargeFile();
+void testSegmentedFile();
+void testConcurrentGrowth();
+void testSyncPolicy();
+void testPageSize();
+
+int main () 
+{
+    testVectoredBlocks();
+    testGrowth();
+    testLargeFile();
+    testSegmentedFile();
+    testConcurrentGrowth();
+    testSyncPolicy();
+    testPageSize();
+    return 0;
+}
+
+void testVectoredBlocks()
+{
+    char* testName = "testVectoredBlocks";
+    SM_FileHandle fHandle;
+    SM_PageHandle buffers[NUM_TEST_PAGES];
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE);
+    remove(TEST_FILE_NAME);
+
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(NUM_TEST_PAGES + 1, &fHandle));
+
+    // write pages 1 through NUM_TEST_PAGES with a single call
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        buffers[i] = (SM_PageHandle)malloc(PAGE_SIZE);
+        memset(buffers[i], 'a' + i, PAGE_SIZE);
+    }
+    TEST_CHECK(writeBlocks(1, NUM_TEST_PAGES, &fHandle, buffers));
+
+    // each page should be readable on its own
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        TEST_CHECK(readBlock(i + 1, &fHandle, page));
+        ASSERT_TRUE(page[0] == 'a' + i && page[PAGE_SIZE - 1] == 'a' + i, "page written by writeBlocks is read back by readBlock");
+    }
+
+    // read the run back with a single call
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        memset(buffers[i], 0, PAGE_SIZE);
+    TEST_CHECK(readBlocks(1, NUM_TEST_PAGES, &fHandle, buffers));
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        ASSERT_TRUE(buffers[i][0] == 'a' + i && buffers[i][PAGE_SIZE - 1] == 'a' + i, "page is read back by readBlocks");
+
+    // runs that go past the end of the file should fail
+    ASSERT_ERROR(readBlocks(2, NUM_TEST_PAGES, &fHandle, buffers), "reading past the last page should fail");
+    ASSERT_ERROR(writeBlocks(-1, 2, &fHandle, buffers), "writing before the first page should fail");
+
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        free(buffers[i]);
+    free(page);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testGrowth()
+{
+    char* testName = "testGrowth";
+    SM_FileHandle fHandle, stale;
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE);
+    remove(TEST_FILE_NAME);
+
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &stale));
+
+    // without a growth factor the file grows to exactly what was asked for
+    TEST_CHECK(ensureCapacity(1000, &fHandle));
+    ASSERT_EQUALS_INT(1000, fHandle.totalNumPages, "file grew to the requested size");
+    TEST_CHECK(appendEmptyBlock(&fHandle));
+    ASSERT_EQUALS_INT(1001, fHandle.totalNumPages, "append adds a single page");
+
+    // with a growth factor the file grows by a whole extent
+    ASSERT_ERROR(setGrowthFactor(0.5, &fHandle), "a growth factor below 1 is rejected");
+    TEST_CHECK(setGrowthFactor(2, &fHandle));
+    TEST_CHECK(ensureCapacity(1002, &fHandle));
+    ASSERT_EQUALS_INT(2002, fHandle.totalNumPages, "file grew by the growth factor");
+    TEST_CHECK(ensureCapacity(2000, &fHandle));
+    ASSERT_EQUALS_INT(2002, fHandle.totalNumPages, "file does not grow when it is big enough");
+
+    // preallocated pages read back as `\0` bytes
+    memset(page, 'x', PAGE_SIZE);
+    TEST_CHECK(readBlock(1500, &fHandle, page));
+    ASSERT_TRUE(page[0] == '\0' && page[PAGE_SIZE - 1] == '\0', "preallocated page is empty");
+
+    // a handle that still counts one page never shrinks the file when it grows it
+    memset(page, 'y', PAGE_SIZE);
+    TEST_CHECK(writeBlock(2001, &fHandle, page));
+    TEST_CHECK(appendEmptyBlock(&stale));
+    TEST_CHECK(closePageFile(&stale));
+    memset(page, 0, PAGE_SIZE);
+    TEST_CHECK(readBlock(2001, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'y' && page[PAGE_SIZE - 1] == 'y', "the last page is still there");
+
+    // the size survives reopening the file
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    ASSERT_EQUALS_INT(2002, fHandle.totalNumPages, "preallocated pages are part of the file");
+
+    free(page);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testLargeFile()
+{
+    char* testName = "testLargeFile";
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE);
+    int lastPage = 600000; // past the 2 GiB offset of page 524288
+    remove(TEST_FILE_NAME);
+
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    TEST_CHECK(ensureCapacity(lastPage + 1, &fHandle));
+
+    // write a page past 2 GiB and make sure it does not land on a lower offset
+    memset(page, 'z', PAGE_SIZE);
+    TEST_CHECK(writeBlock(lastPage, &fHandle, page));
+    TEST_CHECK(readBlock(lastPage - 524288, &fHandle, page));
+    ASSERT_TRUE(page[0] == '\0', "page at the wrapped 32 bit offset is untouched");
+    TEST_CHECK(readBlock(lastPage, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'z', "page past 2 GiB is read back");
+
+    // the page count survives reopening the file
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    ASSERT_EQUALS_INT(lastPage + 1, fHandle.totalNumPages, "file size past 2 GiB is read back");
+
+    free(page);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testSegmentedFile()
+{
+    char* testName = "testSegmentedFile";
+    SM_FileHandle fHandle;
+    SM_PageHandle buffers[NUM_TEST_PAGES];
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE);
+    char *dirs[] = { "SEG_A", "SEG_B" };
+    mkdir(dirs[0], 0755);
+    mkdir(dirs[1], 0755);
+    remove(TEST_FILE_NAME);
+
+    // 3 pages per segment striped over two directories
+    TEST_CHECK(createSegmentedPageFile(TEST_FILE_NAME, PAGE_SIZE, 3, 2, dirs));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    ASSERT_EQUALS_INT(1, fHandle.totalNumPages, "a new segmented file has one page");
+    TEST_CHECK(ensureCapacity(NUM_TEST_PAGES + 1, &fHandle));
+    ASSERT_TRUE(access("SEG_A/TEST.bin.0", F_OK) == 0, "segment 0 is in the first directory");
+    ASSERT_TRUE(access("SEG_B/TEST.bin.1", F_OK) == 0, "segment 1 is in the second directory");
+    ASSERT_TRUE(access("SEG_A/TEST.bin.2", F_OK) == 0, "segment 2 wraps back to the first directory");
+
+    // a vectored write that spans several segments
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        buffers[i] = (SM_PageHandle)malloc(PAGE_SIZE);
+        memset(buffers[i], 'a' + i, PAGE_SIZE);
+    }
+    TEST_CHECK(writeBlocks(1, NUM_TEST_PAGES, &fHandle, buffers));
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        TEST_CHECK(readBlock(i + 1, &fHandle, page));
+        ASSERT_TRUE(page[0] == 'a' + i && page[PAGE_SIZE - 1] == 'a' + i, "page is read back from its segment");
+    }
+
+    // the page count survives reopening the file
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    ASSERT_EQUALS_INT(NUM_TEST_PAGES + 1, fHandle.totalNumPages, "segmented file size is read back");
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        memset(buffers[i], 0, PAGE_SIZE);
+    TEST_CHECK(readBlocks(1, NUM_TEST_PAGES, &fHandle, buffers));
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        ASSERT_TRUE(buffers[i][0] == 'a' + i, "page is read back by readBlocks across segments");
+    SM_FileHandle mapped;
+    ASSERT_ERROR(openPageFileMode(TEST_FILE_NAME, &mapped, SM_MODE_MMAP), "segmented files can not be mapped");
+
+    // destroying the file removes every segment
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+        free(buffers[i]);
+    free(page);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    ASSERT_TRUE(access("SEG_A/TEST.bin.0", F_OK) != 0 && access("SEG_B/TEST.bin.1", F_OK) != 0, "segments were removed");
+    rmdir(dirs[0]);
+    rmdir(dirs[1]);
+
+    // a segmented file whose segment paths would be cut short isn't created
+    char longName[SM_MAX_PATH];
+    memset(longName, 'x', SM_MAX_PATH - 4);
+    longName[SM_MAX_PATH - 4] = '\0';
+    ASSERT_ERROR(createSegmentedPageFile(longName, PAGE_SIZE, 3, 0, NULL), "a file name too long for its segments fails");
+    ASSERT_TRUE(access(longName, F_OK) != 0, "no manifest was written");
+    char *longDirs[] = { longName };
+    ASSERT_ERROR(createSegmentedPageFile(TEST_FILE_NAME, PAGE_SIZE, 3, 1, longDirs), "a directory too long for the segments fails");
+    ASSERT_TRUE(access(TEST_FILE_NAME, F_OK) != 0, "no manifest was written");
+    TEST_DONE();
+}
+
+// keeps reading pages that exist until `stop` is set, counts the reads that failed
+typedef struct GrowthReader {
+    SM_FileHandle *fHandle;
+    int stop;
+    int numFailed;
+} GrowthReader;
+
+void *readWhileGrowing(void *arg)
+{
+    GrowthReader *reader = (GrowthReader *)arg;
+    SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE);
+    unsigned int seed = 1;
+    while (!__atomic_load_n(&(reader->stop), __ATOMIC_ACQUIRE))
+    {
+        int numPages = __atomic_load_n(&(reader->fHandle->totalNumPages), __ATOMIC_ACQUIRE);
+        if (readBlock(rand_r(&seed) % numPages, reader->fHandle, page) != RC_OK)
+            reader->numFailed++;
+    }
+    free(page);
+    return NULL;
+}
+
+void testConcurrentGrowth()
+{
+    char* testName = "testConcurrentGrowth";
+    SM_FileHandle fHandle;
+    GrowthReader readers[2];
+    pthread_t threads[2];
+    int numPages = 512;
+    remove(TEST_FILE_NAME);
+
+    // one page per segment, so every page appended opens another segment while the readers run
+    TEST_CHECK(createSegmentedPageFile(TEST_FILE_NAME, PAGE_SIZE, 1, 0, NULL));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    for (int i = 0; i < 2; i++)
+    {
+        readers[i].fHandle = &fHandle;
+        readers[i].stop = 0;
+        readers[i].numFailed = 0;
+        pthread_create(&threads[i], NULL, readWhileGrowing, &readers[i]);
+    }
+    for (int i = 1; i < numPages; i++)
+        TEST_CHECK(appendEmptyBlock(&fHandle));
+    for (int i = 0; i < 2; i++)
+    {
+        __atomic_store_n(&(readers[i].stop), 1, __ATOMIC_RELEASE);
+        pthread_join(threads[i], NULL);
+        ASSERT_EQUALS_INT(0, readers[i].numFailed, "every page in range was read while the file grew");
+    }
+    ASSERT_EQUALS_INT(numPages, fHandle.totalNumPages, "every page was appended");
+
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+// makes one sync request from its own thread
+typedef struct SyncRequest {
+    SM_FileHandle *fHandle;
+    RC result;
+} SyncRequest;
+
+void *requestSync(void *arg)
+{
+    SyncRequest *request = (SyncRequest *)arg;
+    request->result = syncPageFile(request->fHandle);
+    return NULL;
+}
+
+void testSyncPolicy()
+{
+    char* testName = "testSyncPolicy";
+    SM_FileHandle fHandle;
+    SM_SyncStats stats;
+    remove(TEST_FILE_NAME);
+
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+
+    // by default nothing is fsync'd
+    for (int i = 0; i < 5; i++)
+        TEST_CHECK(syncPageFile(&fHandle));
+    TEST_CHECK(getSyncStats(&fHandle, &stats));
+    ASSERT_EQUALS_INT(5, (int)stats.numRequests, "requests are counted");
+    ASSERT_EQUALS_INT(0, (int)stats.numSyncs, "no fsync without a sync policy");
+
+    // every request is fsync'd
+    TEST_CHECK(setSyncPolicy(SM_SYNC_FLUSH, 0, 0, &fHandle));
+    for (int i = 0; i < 3; i++)
+        TEST_CHECK(syncPageFile(&fHandle));
+    TEST_CHECK(getSyncStats(&fHandle, &stats));
+    ASSERT_EQUALS_INT(3, (int)stats.numSyncs, "each request is fsync'd");
+    ASSERT_TRUE(stats.maxSyncMicros >= 0 && stats.totalSyncMicros >= stats.maxSyncMicros, "fsync latencies are recorded");
+
+    // four requests from four threads wait for each other and share one fsync once the size window fills up
+    ASSERT_ERROR(setSyncPolicy(SM_SYNC_GROUP, 0, 4, &fHandle), "group commit needs a time window");
+    TEST_CHECK(setSyncPolicy(SM_SYNC_GROUP, 10000000, 4, &fHandle));
+    SyncRequest requests[4];
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++)
+    {
+        requests[i].fHandle = &fHandle;
+        pthread_create(&threads[i], NULL, requestSync, &requests[i]);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQUALS_INT(RC_OK, requests[i].result, "a request returns once its group is fsync'd");
+    }
+    TEST_CHECK(getSyncStats(&fHandle, &stats));
+    ASSERT_EQUALS_INT(4, (int)stats.numSyncs, "a full window is fsync'd once");
+
+    // a request whose window does not fill up waits for the fsync when its time runs out
+    TEST_CHECK(setSyncPolicy(SM_SYNC_GROUP, 20000, 100, &fHandle));
+    TEST_CHECK(syncPageFile(&fHandle));
+    TEST_CHECK(getSyncStats(&fHandle, &stats));
+    ASSERT_EQUALS_INT(5, (int)stats.numSyncs, "an expired window is fsync'd before the request returns");
+
+    // closing the file makes pending requests durable
+    TEST_CHECK(syncPageFile(&fHandle));
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+    TEST_DONE();
+}
+
+void testPageSize()
+{
+    char* testName = "testPageSize";
+    SM_FileHandle fHandle;
+    struct stat st;
+    int pageSize = 4 * PAGE_SIZE;
+    SM_PageHandle page = (SM_PageHandle)malloc(pageSize);
+    remove(TEST_FILE_NAME);
+
+    // page sizes that aren't a power of two from PAGE_SIZE up are refused
+    ASSERT_ERROR(createPageFileSize(TEST_FILE_NAME, PAGE_SIZE / 2), "a page size below PAGE_SIZE fails");
+    ASSERT_ERROR(createPageFileSize(TEST_FILE_NAME, 3 * PAGE_SIZE), "a page size that isn't a power of two fails");
+    ASSERT_ERROR(createPageFileSize(TEST_FILE_NAME, 2 * SM_MAX_PAGE_SIZE), "a page size above SM_MAX_PAGE_SIZE fails");
+
+    // the page size is read back from the header
+    TEST_CHECK(createPageFileSize(TEST_FILE_NAME, pageSize));
+    TEST_CHECK(openPageFileMode(TEST_FILE_NAME, &fHandle, SM_MODE_MMAP));
+    ASSERT_EQUALS_INT(pageSize, fHandle.pageSize, "page size comes from the file header");
+    ASSERT_EQUALS_INT(1, fHandle.totalNumPages, "a new file has one page");
+    TEST_CHECK(ensureCapacity(NUM_TEST_PAGES, &fHandle));
+    stat(TEST_FILE_NAME, &st);
+    ASSERT_TRUE(st.st_size == SM_IO_ALIGNMENT + (off_t)NUM_TEST_PAGES * pageSize, "the file is a header followed by whole pages");
+
+    // pages written through the mapping are found at the same place by plain reads
+    SM_PageHandle mapped;
+    TEST_CHECK(mapBlock(NUM_TEST_PAGES - 1, &fHandle, &mapped));
+    memset(mapped, 'm', pageSize);
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    for (int i = 0; i < NUM_TEST_PAGES - 1; i++)
+    {
+        memset(page, 'a' + i, pageSize);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    bool matches = true;
+    for (int i = 0; i < NUM_TEST_PAGES; i++)
+    {
+        char expected = (i == NUM_TEST_PAGES - 1) ? 'm' : 'a' + i;
+        TEST_CHECK(readBlock(i, &fHandle, page));
+        matches = matches && page[0] == expected && page[pageSize - 1] == expected;
+    }
+    ASSERT_TRUE(matches, "large pages are read and written whole");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+
+    // files without a header are legacy PAGE_SIZE files
+    TEST_CHECK(createPageFile(TEST_FILE_NAME));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    ASSERT_EQUALS_INT(PAGE_SIZE, fHandle.pageSize, "a headerless file uses PAGE_SIZE");
+    stat(TEST_FILE_NAME, &st);
+    ASSERT_TRUE(st.st_size == PAGE_SIZE, "a headerless file has no header");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+
+    // segmented files keep the page size in their manifest
+    TEST_CHECK(createSegmentedPageFile(TEST_FILE_NAME, pageSize, 2, 0, NULL));
+    TEST_CHECK(openPageFile(TEST_FILE_NAME, &fHandle));
+    ASSERT_EQUALS_INT(pageSize, fHandle.pageSize, "page size comes from the manifest");
+    TEST_CHECK(ensureCapacity(3, &fHandle));
+    memset(page, 's', pageSize);
+    TEST_CHECK(writeBlock(2, &fHandle, page));
+    memset(page, 0, pageSize);
+    TEST_CHECK(readBlock(2, &fHandle, page));
+    ASSERT_TRUE(page[0] == 's' && page[pageSize - 1] == 's', "large pages span segments whole");
+    stat("TEST.bin.1", &st);
+    ASSERT_TRUE(st.st_size == pageSize, "segments hold whole pages without a header");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile(TEST_FILE_NAME));
+
+    free(page);
+    TEST_DONE();
+}